@@ -0,0 +1,27 @@
+if(NOT LIBZSTD_FOUND)
+  pkg_check_modules (LIBZSTD_PKG libzstd)
+  find_path(LIBZSTD_INCLUDE_DIR NAMES zstd.h
+    PATHS
+    ${LIBZSTD_PKG_INCLUDE_DIRS}
+    /usr/include
+    /usr/local/include
+  )
+
+  find_library(LIBZSTD_LIBRARIES NAMES zstd
+    PATHS
+    ${LIBZSTD_PKG_LIBRARY_DIRS}
+    /usr/lib
+    /usr/local/lib
+  )
+
+if(LIBZSTD_INCLUDE_DIR AND LIBZSTD_LIBRARIES)
+  set(LIBZSTD_FOUND TRUE CACHE INTERNAL "libzstd found")
+  message(STATUS "Found libzstd: ${LIBZSTD_INCLUDE_DIR}, ${LIBZSTD_LIBRARIES}")
+else(LIBZSTD_INCLUDE_DIR AND LIBZSTD_LIBRARIES)
+  set(LIBZSTD_FOUND FALSE CACHE INTERNAL "libzstd found")
+  message(STATUS "libzstd not found.")
+endif(LIBZSTD_INCLUDE_DIR AND LIBZSTD_LIBRARIES)
+
+mark_as_advanced(LIBZSTD_INCLUDE_DIR LIBZSTD_LIBRARIES)
+
+endif(NOT LIBZSTD_FOUND)
@@ -32,6 +32,7 @@ self.\$(id).set_sample_rate(\$sample_rate)
 \#if \$nchan() > $n
 self.\$(id).set_center_freq(\$freq$(n), $n)
 self.\$(id).set_freq_corr(\$corr$(n), $n)
+self.\$(id).set_dc_offset_mode(\$dc_offset_mode$(n), $n)
 self.\$(id).set_iq_balance_mode(\$iq_balance_mode$(n), $n)
 self.\$(id).set_gain_mode(\$gain_mode$(n), $n)
 self.\$(id).set_gain(\$gain$(n), $n)
@@ -46,6 +47,7 @@ self.\$(id).set_bandwidth(\$bw$(n), $n)
   #for $n in range($max_nchan)
   <callback>set_center_freq(\$freq$(n), $n)</callback>
   <callback>set_freq_corr(\$corr$(n), $n)</callback>
+  <callback>set_dc_offset_mode(\$dc_offset_mode$(n), $n)</callback>
   <callback>set_iq_balance_mode(\$iq_balance_mode$(n), $n)</callback>
   <callback>set_gain_mode(\$gain_mode$(n), $n)</callback>
   <callback>set_gain(\$gain$(n), $n)</callback>
@@ -114,6 +116,7 @@ While primarily being developed for the OsmoSDR hardware, this block as well sup
  * Ettus USRP Devices through Ettus UHD library
  * RTL2832U based DVB-T dongles through librtlsdr
  * RTL-TCP spectrum server (see librtlsdr project)
+ * UDP IQ streams (sequence numbered cs8/cs16/cf32 datagrams)
  * MSi2500 based DVB-T dongles through libmirisdr
  * gnuradio .cfile input through libgnuradio-core
 
@@ -133,38 +136,61 @@ Lines ending with ... mean it's possible to bind devices together by specifying
 
 Source Mode:
   fcd=0
-  hackrf=0[,buffers=32]
-  miri=0[,buffers=32] ...
+  hackrf=0[,buffers=32][,record=/path/to/capture.cu8][,record_rotate=1e9][,settle=0.005][,ddc=10][,ddc_offset=2e6]
+  hackrf=0,pfb_chans=16 ...
+  miri=0[,buffers=32][,record=/path/to/capture.cs16][,record_rotate=1e9] ...
   rtl=serial_number ...
   rtl=0[,rtl_xtal=28.8e6][,tuner_xtal=28.8e6] ...
   rtl=1[,buffers=32][,buflen=N*512] ...
   rtl=2[,direct_samp=0|1|2][,offset_tune=0|1] ...
+  rtl=3[,record=/path/to/capture.cu8][,record_rotate=1e9] ...
+  rtl=4[,record=/path/to/capture.cu8.zst][,record_compress=1] ...
+  rtl=5[,settle=0.005] ...
+  rtl=6[,ddc=8][,ddc_offset=250e3] ...
   rtl_tcp=127.0.0.1:1234[,psize=16384][,direct_samp=0|1|2][,offset_tune=0|1] ...
+  udp=[0.0.0.0:]1234,rate=1e6[,freq=100e6][,format=cu8|cs8|cs16|cf32][,window=16][,batch=32][,psize=65536][,rcvbuf=8388608] ...
   uhd[,serial=...][,lo_offset=0][,mcr=52e6][,nchan=2][,subdev='\\\\'B:0 A:0\\\\''] ...
-  osmosdr=0[,buffers=32][,buflen=N*512] ...
-  file='/path/to/your file',rate=1e6[,freq=100e6][,repeat=true][,throttle=true] ...
+  osmosdr=0[,buffers=32][,buflen=N*512][,record=/path/to/capture.cs16] ...
+  file='/path/to/your file',rate=1e6[,freq=100e6][,format=cu8|cs8|cs16|cf32][,repeat=true][,throttle=true][,mmap=true][,offset=0|2400s][,length=N|2s] ...
+  file='/path/to/your capture.sigmf-data'[,meta='/path/to/your capture.sigmf-meta'] ...
+  file='/path/to/rx0;/path/to/rx1',nchan=2 or file='/path/to/interleaved',nchan=2 ...
+  file='/path/to/your capture.cs8.zst',rate=1e6[,threads=4] ...
 
 Sink Mode:
   hackrf=0[,buffers=32]
   uhd[,serial=...][,lo_offset=0][,mcr=52e6][,nchan=2][,subdev='\\\\'B:0 A:0\\\\''] ...
+  file='/path/to/your file',rate=1e6[,freq=100e6][,format=cu8|cs8|cs16|cf32][,throttle=true][,append=false] ...
 
 Num Channels:
 Selects the total number of channels in this multi-device configuration. Required when specifying multiple device arguments.
+With pfb_chans=M given for a device, each of its channels is split into M outputs of rate/M, output k centered at frequency + k * rate/M (wrapping to negative offsets in the upper half). They count as M channels here and only the settings of the first one are applied to the device. The sample rate entered here remains the one of the device.
 
 Sample Rate:
 The sample rate is the number of samples per second output by this block on each channel.
+With ddc=N, RTL-SDR and HackRF sources run the device N times faster and filter and decimate the samples before passing them on. All rates and frequencies are those of the output.
 
 Frequency:
 The center frequency is the frequency the RF chain is tuned to.
+RTL-SDR and HackRF sources tag the first sample taken after a change of frequency, sample rate or RF gain with rx_freq, rx_rate or rx_gain. With settle= given (in seconds), the samples captured while the device settles are dropped before it.
+With ddc_offset= given (in Hz), the device is tuned that far below the center frequency and the channel is shifted back digitally, which keeps the DC spike out of it.
 
 Freq. Corr.:
 The frequency correction factor in parts per million (ppm). Set to 0 if unknown.
 
+DC Offset Mode:
+Controls the behavior of DC offset correction.
+  Off: Disable correction algorithm (pass through).
+  Manual: Keep last estimated correction when switched from Automatic to Manual.
+  Automatic: Periodicallly find and remove the DC offset.
+RTL-SDR and HackRF sources estimate the offset from a fraction of the sample buffers and remove it during sample conversion. UHD devices do it in hardware.
+
 IQ Balance Mode:
 Controls the behavior of software IQ imbalance corrrection.
   Off: Disable correction algorithm (pass through).
   Manual: Keep last estimated correction when switched from Automatic to Manual.
   Automatic: Periodicallly find the best solution to compensate for image signals.
+RTL-SDR and HackRF sources apply the correction while converting the samples, other devices get a separate correction block.
+With iqbal_decim=N in the device arguments, the estimator only looks at one chunk of samples out of every N, which cuts its CPU load accordingly.
 
 This functionality depends on http://cgit.osmocom.org/cgit/gr-iqbal/
 
@@ -214,6 +240,25 @@ PARAMS_TMPL = """
     <type>real</type>
     <hide>\#if \$nchan() > $n then 'none' else 'all'#</hide>
   </param>
+  <param>
+    <name>Ch$(n): DC Offset Mode</name>
+    <key>dc_offset_mode$(n)</key>
+    <value>0</value>
+    <type>int</type>
+    <hide>\#if \$nchan() > $n then 'none' else 'all'#</hide>
+    <option>
+      <name>Off</name>
+      <key>0</key>
+    </option>
+    <option>
+      <name>Manual</name>
+      <key>1</key>
+    </option>
+    <option>
+      <name>Automatic</name>
+      <key>2</key>
+    </option>
+  </param>
   <param>
     <name>Ch$(n): IQ Balance Mode</name>
     <key>iq_balance_mode$(n)</key>
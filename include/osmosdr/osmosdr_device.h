@@ -100,11 +100,23 @@ namespace osmosdr {
      *
      * The device hint should be used to narrow down the search
      * to particular transport types and/or transport arguments.
+     * Naming device types (e.g. "rtl,hackrf") limits the search to
+     * these, other values given have to match the devices found.
+     * The backends are asked in parallel.
      *
      * \param hint a partially (or fully) filled in logical device
      * \return a vector of logical devices for all radios on the system
      */
     static devices_t find(const device_t &hint = osmosdr::device_t());
+
+    /*!
+     * \brief Forget the results of previous device searches.
+     *
+     * find() reuses what the backends reported for a few seconds.
+     * Call this after attaching or removing hardware to see the change
+     * with the next search.
+     */
+    static void invalidate_cache(void);
   };
 
 } //namespace osmosdr
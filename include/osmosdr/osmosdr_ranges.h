@@ -19,7 +19,6 @@
 #define INCLUDED_OSMOSDR_RANGES_H
 
 #include <osmosdr/osmosdr_api.h>
-#include <osmosdr/osmosdr_pimpl.h>
 #include <string>
 #include <vector>
 
@@ -28,6 +27,8 @@ namespace osmosdr{
     /*!
      * A range object describes a set of discrete values of the form:
      * y = start + step*n, where n is an integer between 0 and (stop - start)/step
+     *
+     * Ranges are plain values, copying one doesn't allocate.
      */
     class OSMOSDR_API range_t{
     public:
@@ -60,11 +61,18 @@ namespace osmosdr{
         //! Convert this range to a printable string
         const std::string to_pp_string(void) const;
 
-    private: OSMOSDR_PIMPL_DECL(impl) _impl;
+    private:
+        double _start, _stop, _step;
     };
 
     /*!
      * A meta-range object holds a list of individual ranges.
+     *
+     * The ranges are validated and the overall start, stop and step are
+     * computed when the meta-range is first used after ranges were added,
+     * later calls are answered from the cache and clip() does a binary
+     * search. Ranges replaced in place aren't noticed, so build the list by
+     * appending to it, before it is shared between threads.
      */
     struct OSMOSDR_API meta_range_t : std::vector<range_t>{
 
@@ -79,7 +87,9 @@ namespace osmosdr{
          */
         template <typename InputIterator>
         meta_range_t(InputIterator first, InputIterator last):
-            std::vector<range_t>(first, last){ /* NOP */ }
+            std::vector<range_t>(first, last), _valid_size(0){
+            if (! this->empty()) update();
+        }
 
         /*!
          * A convenience constructor for a single range.
@@ -113,6 +123,17 @@ namespace osmosdr{
         //! Convert this meta-range to a printable string
         const std::string to_pp_string(void) const;
 
+        /*!
+         * Validate the ranges and cache the overall values, if not done yet.
+         * The constructors do this already. A range filled by push_back()
+         * has to be updated once before it is shared between threads,
+         * otherwise the first reader writes the cache.
+         */
+        void update(void) const;
+
+    private:
+        mutable size_t _valid_size; //!< number of ranges the cache is valid for
+        mutable double _start, _stop, _step;
     };
 
     typedef meta_range_t gain_range_t;
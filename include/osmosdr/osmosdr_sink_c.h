@@ -53,6 +53,13 @@ OSMOSDR_API osmosdr_sink_c_sptr osmosdr_make_sink_c ( const std::string & args =
  * \ingroup block
  *
  * This uses the preferred technique: subclassing gr_hier_block2.
+ *
+ * Besides the method calls, the block takes commands as messages. A command
+ * is a PMT dict with any of the keys rate, freq, gain, bandwidth and antenna,
+ * and optionally chan (default 0). Commands are applied in order on a thread
+ * of their own, the actual values are then published as a dict, with an
+ * error entry on failure. A hierarchical block can't have message ports, so
+ * they live on the block returned by control_block().
  */
 class OSMOSDR_API osmosdr_sink_c : virtual public gr_hier_block2
 {
@@ -264,6 +271,29 @@ public:
   virtual void set_iq_balance( const std::complex<double> &correction,
                                size_t chan = 0 ) = 0;
 
+  enum DCOffsetMode {
+    DCOffsetOff = 0,
+    DCOffsetManual,
+    DCOffsetAutomatic
+  };
+
+  /*!
+   * Set the TX frontend DC offset correction mode.
+   *
+   * \param mode dc offset correction mode: 0 = Off, 1 = Manual, 2 = Automatic
+   * \param chan the channel index 0 to N-1
+   */
+  virtual void set_dc_offset_mode( int mode, size_t chan = 0 ) = 0;
+
+  /*!
+   * Set the TX frontend DC offset correction.
+   *
+   * \param offset the complex offset, in units of full scale
+   * \param chan the channel index 0 to N-1
+   */
+  virtual void set_dc_offset( const std::complex<double> &offset,
+                              size_t chan = 0 ) = 0;
+
   /*!
    * Set the bandpass filter on the radio frontend.
    * \param bandwidth the filter bandwidth in Hz
@@ -285,6 +315,35 @@ public:
    * \return a range of bandwidths in Hz
    */
   virtual osmosdr::freq_range_t get_bandwidth_range( size_t chan = 0 ) = 0;
+
+  /*!
+   * Tune several channels in one call.
+   * \param freqs center frequencies in Hz, the first one applies to channel 0
+   * \return the actual center frequencies in Hz
+   */
+  virtual std::vector< double > set_center_freqs( const std::vector< double > &freqs ) = 0;
+
+  /*!
+   * Set the overall gain of several channels in one call.
+   * \param gains gains in dB, the first one applies to channel 0
+   * \return the actual gains in dB
+   */
+  virtual std::vector< double > set_gains( const std::vector< double > &gains ) = 0;
+
+  /*!
+   * Set the frontend bandpass filter of several channels in one call.
+   * \param bandwidths filter bandwidths in Hz, the first one applies to channel 0
+   * \return the actual filter bandwidths in Hz
+   */
+  virtual std::vector< double > set_bandwidths( const std::vector< double > &bandwidths ) = 0;
+
+  /*!
+   * Get the block taking the commands, to be wired with msg_connect().
+   * Its "command" input port takes the command dicts, its "status" output
+   * port publishes the outcome of every command.
+   * \return the command block, part of the flowgraph of this block
+   */
+  virtual gr_basic_block_sptr control_block( void ) = 0;
 };
 
 #endif /* INCLUDED_OSMOSDR_SINK_C_H */
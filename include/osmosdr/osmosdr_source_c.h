@@ -23,6 +23,7 @@
 #include <osmosdr/osmosdr_api.h>
 #include <osmosdr/osmosdr_ranges.h>
 #include <gnuradio/gr_hier_block2.h>
+#include <boost/thread/future.hpp>
 
 class osmosdr_source_c;
 
@@ -39,6 +40,9 @@ class osmosdr_source_c;
  */
 typedef boost::shared_ptr<osmosdr_source_c> osmosdr_source_c_sptr;
 
+/* the outcome of a setting which is applied in the background */
+typedef boost::shared_future< double > osmosdr_future_t;
+
 /*!
  * \brief Return a shared_ptr to a new instance of osmosdr_source_c.
  *
@@ -53,6 +57,20 @@ OSMOSDR_API osmosdr_source_c_sptr osmosdr_make_source_c ( const std::string & ar
  * \ingroup block
  *
  * This uses the preferred technique: subclassing gr_hier_block2.
+ *
+ * Besides the method calls, the block takes commands as messages. A command
+ * is a PMT dict with any of the keys rate, freq, gain, bandwidth and antenna,
+ * and optionally chan (default 0). Commands are applied in order on a thread
+ * of their own, the actual values are then published as a dict, with an
+ * error entry on failure. A hierarchical block can't have message ports, so
+ * they live on the block returned by control_block().
+ *
+ * With pfb_chans=M in the arguments of a device, a polyphase filterbank
+ * splits each of its channels into M outputs of rate/M samples per second.
+ * Output k is centered at freq + k * rate/M, the upper half wrapping around
+ * to negative offsets, which is what get_center_freq() and get_freq_range()
+ * report for them. The first of these outputs controls the device channel,
+ * setting any of the others returns the current value and changes nothing.
  */
 class OSMOSDR_API osmosdr_source_c : virtual public gr_hier_block2
 {
@@ -79,6 +97,7 @@ public:
   /*!
    * Get the sample rate for the underlying radio hardware.
    * This is the actual sample rate and may differ from the rate set.
+   * The outputs of a device with pfb_chans=M run at this rate divided by M.
    * \return the actual rate in Sps
    */
   virtual double get_sample_rate( void ) = 0;
@@ -107,6 +126,17 @@ public:
    */
   virtual double get_center_freq( size_t chan = 0 ) = 0;
 
+  /*!
+   * Tune without waiting for the hardware.
+   * Devices with a control thread (RTL-SDR, HackRF and bladeRF) replace a
+   * setting which hasn't been applied yet by the latest one, others apply
+   * it right away.
+   * \param freq the desired frequency in Hz
+   * \param chan the channel index 0 to N-1
+   * \return a future for the actual frequency in Hz
+   */
+  virtual osmosdr_future_t post_center_freq( double freq, size_t chan = 0 ) = 0;
+
   /*!
    * Set the frequency correction value in parts per million.
    * \param ppm the desired correction value in parts per million
@@ -171,6 +201,15 @@ public:
    */
   virtual double set_gain( double gain, size_t chan = 0 ) = 0;
 
+  /*!
+   * Set the overall gain without waiting for the hardware.
+   * See post_center_freq() for how pending settings are treated.
+   * \param gain the gain in dB
+   * \param chan the channel index 0 to N-1
+   * \return a future for the actual gain in dB
+   */
+  virtual osmosdr_future_t post_gain( double gain, size_t chan = 0 ) = 0;
+
   /*!
    * Set the named gain on the underlying radio hardware.
    * \param gain the gain in dB
@@ -264,6 +303,32 @@ public:
   virtual void set_iq_balance( const std::complex<double> &correction,
                                size_t chan = 0 ) = 0;
 
+  enum DCOffsetMode {
+    DCOffsetOff = 0,
+    DCOffsetManual,
+    DCOffsetAutomatic
+  };
+
+  /*!
+   * Set the RX frontend DC offset correction mode.
+   * In automatic mode the offset is estimated continuously from the
+   * samples, switching to manual keeps the last estimate.
+   *
+   * \param mode dc offset correction mode: 0 = Off, 1 = Manual, 2 = Automatic
+   * \param chan the channel index 0 to N-1
+   */
+  virtual void set_dc_offset_mode( int mode, size_t chan = 0 ) = 0;
+
+  /*!
+   * Set the RX frontend DC offset correction.
+   * The value is subtracted from the samples, it is ignored in automatic mode.
+   *
+   * \param offset the complex offset, in units of full scale
+   * \param chan the channel index 0 to N-1
+   */
+  virtual void set_dc_offset( const std::complex<double> &offset,
+                              size_t chan = 0 ) = 0;
+
   /*!
    * Set the bandpass filter on the radio frontend.
    * \param bandwidth the filter bandwidth in Hz
@@ -285,6 +350,71 @@ public:
    * \return a range of bandwidths in Hz
    */
   virtual osmosdr::freq_range_t get_bandwidth_range( size_t chan = 0 ) = 0;
+
+  /*!
+   * Reposition a seekable source, like a recording being played back.
+   * Hardware sources don't support this and return false.
+   * For memory mapped files the position is relative to the window given
+   * by offset= and length=, SEEK_END meaning the end of that window. Unlike
+   * these arguments, seek() takes samples only, not seconds.
+   * \param seek_point the position in samples
+   * \param whence SEEK_SET, SEEK_CUR or SEEK_END as with fseek
+   * \param chan the channel index 0 to N-1
+   * \return true on success
+   */
+  virtual bool seek( long seek_point, int whence, size_t chan = 0 ) = 0;
+
+  /*!
+   * Tune several channels in one call.
+   * \param freqs center frequencies in Hz, the first one applies to channel 0
+   * \return the actual center frequencies in Hz
+   */
+  virtual std::vector< double > set_center_freqs( const std::vector< double > &freqs ) = 0;
+
+  /*!
+   * Set the overall gain of several channels in one call.
+   * \param gains gains in dB, the first one applies to channel 0
+   * \return the actual gains in dB
+   */
+  virtual std::vector< double > set_gains( const std::vector< double > &gains ) = 0;
+
+  /*!
+   * Set the frontend bandpass filter of several channels in one call.
+   * \param bandwidths filter bandwidths in Hz, the first one applies to channel 0
+   * \return the actual filter bandwidths in Hz
+   */
+  virtual std::vector< double > set_bandwidths( const std::vector< double > &bandwidths ) = 0;
+
+  /*!
+   * Let the device step through a list of frequencies on its own.
+   *
+   * The retunes are issued by the driver at transfer boundaries, so a hop
+   * lasts at least dwell + settle seconds, rounded up to whole transfers.
+   * The samples of the settling period are dropped. The first sample of
+   * every hop carries an rx_freq tag and, if requested, a sweep_hop tag
+   * holding the index of the frequency in the list.
+   *
+   * Tuning manually while sweeping is not supported. Currently only RTL-SDR
+   * and HackRF devices are able to sweep.
+   *
+   * \param freqs the frequencies in Hz, an empty list stops sweeping
+   * \param dwell the seconds of samples to deliver per frequency
+   * \param settle the seconds of samples to drop after every retune
+   * \param tag_hops tag the first sample of every hop with its index
+   * \param chan the channel index 0 to N-1
+   * \return false if the device doesn't support sweeping
+   */
+  virtual bool set_sweep( const std::vector< double > &freqs,
+                          double dwell, double settle,
+                          bool tag_hops = true, size_t chan = 0 ) = 0;
+
+  /*!
+   * Get the block taking the commands, to be wired with msg_connect().
+   * Its "command" input port takes the command dicts, its "status" output
+   * port publishes the outcome of every command.
+   * \return the command block, part of the flowgraph of this block
+   */
+  virtual gr_basic_block_sptr control_block( void ) = 0;
 };
 
 #endif /* INCLUDED_OSMOSDR_SOURCE_C_H */
@@ -30,6 +30,7 @@
 
 #include <iostream>
 #include <boost/assign.hpp>
+#include <boost/bind.hpp>
 #include <gnuradio/gr_io_signature.h>
 #include <osmosdr_arg_helpers.h>
 #include <libbladeRF.h>
@@ -96,6 +97,24 @@ bladerf_source_c::bladerf_source_c (const std::string &args)
     this->setup_device();
     this->thread = gruel::thread(read_task_dispatch, this);
   }
+
+  /* the getters answer from here, the device is only asked after a change */
+  _sample_rate = _center_freq = 0;
+
+  /* all stages go in now, later only their values change */
+  std::vector< std::string > names = get_gain_names();
+  for ( size_t i = 0; i < names.size(); i++ )
+    _gains[ names[i] ] = 0;
+
+  try {
+    _sample_rate = read_sample_rate();
+    _center_freq = read_center_freq();
+
+    for ( size_t i = 0; i < names.size(); i++ )
+      _gains[ names[i] ] = read_gain( names[i] );
+  } catch ( std::exception &ex ) {
+    std::cerr << "Failed to read the device settings: " << ex.what() << std::endl;
+  }
 }
 
 /*
@@ -103,6 +122,9 @@ bladerf_source_c::bladerf_source_c (const std::string &args)
  */
 bladerf_source_c::~bladerf_source_c ()
 {
+  /* a setter still running must be done with the device */
+  _setters.stop();
+
   this->set_running(false);
   this->thread.join();
 
@@ -230,7 +252,12 @@ osmosdr::meta_range_t bladerf_source_c::get_sample_rates()
   return this->sample_range;
 }
 
-double bladerf_source_c::set_sample_rate(double rate)
+double bladerf_source_c::set_sample_rate( double rate )
+{
+  return _setters.call( "rate", boost::bind( &bladerf_source_c::apply_sample_rate, this, rate ) );
+}
+
+double bladerf_source_c::apply_sample_rate( double rate )
 {
   /* Set the Si5338 to be 2x this sample rate */
   if( this->dev ) {
@@ -258,10 +285,17 @@ double bladerf_source_c::set_sample_rate(double rate)
     throw std::runtime_error( std::string(__FUNCTION__)
             + " has failed due to lack of device" );
   }
-  return this->get_sample_rate();
+  _sample_rate = read_sample_rate();
+
+  return _sample_rate;
 }
 
 double bladerf_source_c::get_sample_rate()
+{
+  return _sample_rate;
+}
+
+double bladerf_source_c::read_sample_rate()
 {
   int ret;
   unsigned int rv = -1;
@@ -287,6 +321,11 @@ osmosdr::freq_range_t bladerf_source_c::get_freq_range( size_t chan )
 }
 
 double bladerf_source_c::set_center_freq( double freq, size_t chan )
+{
+  return _setters.call( "freq", boost::bind( &bladerf_source_c::apply_center_freq, this, freq, chan ) );
+}
+
+double bladerf_source_c::apply_center_freq( double freq, size_t chan )
 {
   if( this->dev ) {
     int ret;
@@ -305,10 +344,17 @@ double bladerf_source_c::set_center_freq( double freq, size_t chan )
     throw std::runtime_error( std::string(__FUNCTION__)
             + " failed due to lack of device" );
   }
-  return get_center_freq( chan );
+  _center_freq = read_center_freq();
+
+  return _center_freq;
 }
 
 double bladerf_source_c::get_center_freq( size_t chan )
+{
+  return _center_freq;
+}
+
+double bladerf_source_c::read_center_freq()
 {
   uint32_t freq;
   int ret;
@@ -393,8 +439,12 @@ double bladerf_source_c::set_gain( double gain, size_t chan )
   return set_gain( gain, "VGA2", chan );
 }
 
-double
-bladerf_source_c::set_gain( double gain, const std::string & name, size_t chan)
+double bladerf_source_c::set_gain( double gain, const std::string & name, size_t chan )
+{
+  return _setters.call( "gain:" + name, boost::bind( &bladerf_source_c::apply_gain, this, gain, name, chan ) );
+}
+
+double bladerf_source_c::apply_gain( double gain, const std::string & name, size_t chan )
 {
   if( this->dev ) {
     if( name == "LNA" ) {
@@ -423,7 +473,11 @@ bladerf_source_c::set_gain( double gain, const std::string & name, size_t chan)
     throw std::runtime_error( std::string(__FUNCTION__)
             + " failed due to not having a valid device open" );
   }
-  return get_gain( name, 1 );
+  /* the stage is known by now, so this doesn't insert */
+  double value = read_gain( name );
+  _gains.find( name )->second = value;
+
+  return value;
 }
 
 double bladerf_source_c::get_gain( size_t chan )
@@ -433,6 +487,16 @@ double bladerf_source_c::get_gain( size_t chan )
 }
 
 double bladerf_source_c::get_gain( const std::string & name, size_t chan )
+{
+  std::map< std::string, double >::const_iterator it = _gains.find( name );
+  if ( it == _gains.end() )
+    throw std::runtime_error( std::string(__FUNCTION__)
+            + " requested to get the gain of an unknown gain element " + name );
+
+  return it->second;
+}
+
+double bladerf_source_c::read_gain( const std::string & name )
 {
   int g;
   if( this->dev ) {
@@ -480,3 +544,13 @@ std::string bladerf_source_c::get_antenna( size_t chan )
   /* We only have a single receive chain here */
   return "RX";
 }
+
+osmosdr_future_t bladerf_source_c::post_center_freq( double freq, size_t chan )
+{
+  return _setters.post( "freq", boost::bind( &bladerf_source_c::apply_center_freq, this, freq, chan ) );
+}
+
+osmosdr_future_t bladerf_source_c::post_gain( double gain, size_t chan )
+{
+  return _setters.post( "gain:VGA2", boost::bind( &bladerf_source_c::apply_gain, this, gain, std::string( "VGA2" ), chan ) );
+}
@@ -22,12 +22,15 @@
 #ifndef INCLUDED_BLADERF_SOURCE_C_H
 #define INCLUDED_BLADERF_SOURCE_C_H
 
+#include <map>
+
 #include <gruel/thread.h>
 #include <gr_block.h>
 #include <gr_sync_block.h>
 #include <osmosdr/osmosdr_ranges.h>
 #include <libbladeRF.h>
 #include "osmosdr_src_iface.h"
+#include "osmosdr_setter_queue.h"
 #include "bladerf_common.h"
 
 
@@ -114,7 +117,18 @@ private:
   std::string set_antenna( const std::string & antenna, size_t chan = 0 );
   std::string get_antenna( size_t chan = 0 );
 
+  osmosdr_future_t post_center_freq( double freq, size_t chan = 0 );
+  osmosdr_future_t post_gain( double gain, size_t chan = 0 );
+
 private:
+  double apply_sample_rate( double rate );
+  double apply_center_freq( double freq, size_t chan );
+  double apply_gain( double gain, const std::string & name, size_t chan );
+
+  double read_sample_rate();
+  double read_center_freq();
+  double read_gain( const std::string & name );
+
   static void read_task_dispatch(bladerf_source_c *obj);
   void read_task();
 
@@ -125,6 +139,13 @@ private:
   osmosdr::gain_range_t lna_range;
   osmosdr::gain_range_t vga2_range;
   osmosdr::gain_range_t vga1_range;
+
+  /* last applied settings */
+  double _sample_rate;
+  double _center_freq;
+  std::map< std::string, double > _gains;
+
+  osmosdr_setter_queue _setters;
 };
 
 #endif /* INCLUDED_BLADERF_SOURCE_C_H */
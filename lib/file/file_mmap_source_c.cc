@@ -0,0 +1,391 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2013 Dimitri Stolnikov <horiz0n@gmx.net>
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "file_mmap_source_c.h"
+#include <gr_io_signature.h>
+
+#include <stdexcept>
+#include <iostream>
+#include <algorithm>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <stdio.h>
+
+#define READ_AHEAD    (16 * 1024 * 1024) /* bytes to prefetch ahead of the read position */
+#define PACE_QUANTUM  0.001 /* seconds worth of samples released at once */
+#define PACE_MAX_LAG  0.1   /* seconds behind schedule before we give up catching up */
+
+file_mmap_source_c_sptr make_file_mmap_source_c( const std::vector< std::string > &filenames,
+                                                 bool repeat,
+                                                 osmosdr_format_t format,
+                                                 size_t nchan )
+{
+  return gnuradio::get_initial_sptr(new file_mmap_source_c(filenames, repeat,
+                                                           format, nchan));
+}
+
+file_mmap_source_c::file_mmap_source_c( const std::vector< std::string > &filenames,
+                                        bool repeat,
+                                        osmosdr_format_t format,
+                                        size_t nchan )
+  : gr_sync_block ("file_mmap_source_c",
+        gr_make_io_signature (0, 0, 0),
+        gr_make_io_signature (nchan, nchan, sizeof (gr_complex))),
+    _nchan(nchan),
+    _interleaved(false),
+    _format(format),
+    _sample_size(format_sample_size(format)),
+    _stride(0),
+    _nsamples(0),
+    _pos(0),
+    _start(0),
+    _end(0),
+    _ahead(0),
+    _repeat(repeat),
+    _have_meta(false),
+    _announce(true),
+    _pacer(PACE_QUANTUM, PACE_MAX_LAG)
+{
+  if ( filenames.empty() || 0 == nchan )
+    throw std::runtime_error( "No files to play back." );
+
+  if ( filenames.size() > 1 && filenames.size() != nchan )
+    throw std::runtime_error( "The number of files doesn't match the number of channels." );
+
+  _interleaved = ( filenames.size() == 1 && nchan > 1 );
+  _stride = _interleaved ? _sample_size * nchan : _sample_size;
+
+  try {
+    for ( size_t i = 0; i < filenames.size(); i++ )
+      map_file( filenames[i] );
+  } catch ( ... ) {
+    unmap_all();
+    throw;
+  }
+
+  /* play back in lock-step, up to the end of the shortest file */
+  _nsamples = _maps[0].len / _stride;
+  for ( size_t i = 1; i < _maps.size(); i++ )
+    _nsamples = std::min( _nsamples, _maps[i].len / _stride );
+
+  _end = _nsamples;
+
+  read_ahead();
+}
+
+file_mmap_source_c::~file_mmap_source_c()
+{
+  unmap_all();
+
+  if ( _pacer.slips() )
+    std::cerr << "File playback fell behind schedule " << _pacer.slips()
+              << " time(s)." << std::endl;
+}
+
+void file_mmap_source_c::map_file( const std::string &filename )
+{
+  mapping_t m;
+
+  m.fd = open( filename.c_str(), O_RDONLY );
+  if ( m.fd < 0 )
+    throw std::runtime_error( "Failed to open '" + filename + "': " +
+                              strerror(errno) );
+
+  struct stat st;
+  if ( fstat( m.fd, &st ) < 0 ) {
+    close( m.fd );
+    throw std::runtime_error( "Failed to stat '" + filename + "'." );
+  }
+
+  m.len = st.st_size;
+
+  if ( m.len < _stride ) {
+    close( m.fd );
+    throw std::runtime_error( "File '" + filename + "' contains no samples." );
+  }
+
+  void *map = mmap( NULL, m.len, PROT_READ, MAP_SHARED, m.fd, 0 );
+  if ( MAP_FAILED == map ) {
+    close( m.fd );
+    throw std::runtime_error( "Failed to map '" + filename + "': " +
+                              strerror(errno) );
+  }
+
+  m.map = (const unsigned char *)map;
+
+  /* lets the kernel read ahead aggressively and drop pages behind us */
+  madvise( map, m.len, MADV_SEQUENTIAL );
+
+  _maps.push_back( m );
+}
+
+void file_mmap_source_c::unmap_all()
+{
+  for ( size_t i = 0; i < _maps.size(); i++ ) {
+    munmap( (void *)_maps[i].map, _maps[i].len );
+    close( _maps[i].fd );
+  }
+
+  _maps.clear();
+}
+
+void file_mmap_source_c::read_ahead()
+{
+  size_t pos = _pos * _stride;
+
+  /* issue the next prefetch once we've consumed half of the last one */
+  if ( _ahead > pos + READ_AHEAD / 2 )
+    return;
+
+  static const size_t page_size = sysconf(_SC_PAGESIZE);
+
+  size_t start = std::max( pos, _ahead );
+  start -= start % page_size; /* madvise wants page aligned addresses */
+
+  size_t end = std::min( pos + READ_AHEAD, _end * _stride );
+
+  if ( end > start )
+    for ( size_t i = 0; i < _maps.size(); i++ )
+      madvise( (void *)(_maps[i].map + start), end - start, MADV_WILLNEED );
+
+  _ahead = end;
+}
+
+void file_mmap_source_c::set_metadata( const sigmf_meta_t &meta )
+{
+  _meta = meta;
+  _have_meta = true;
+  _announce = true;
+}
+
+void file_mmap_source_c::set_range( uint64_t start, uint64_t length )
+{
+  if ( start >= _nsamples )
+    throw std::runtime_error( "Playback offset lies beyond the end of the file." );
+
+  boost::mutex::scoped_lock lock( _pos_mutex );
+
+  _start = start;
+  _end = _nsamples;
+  if ( length && start + length < _nsamples )
+    _end = start + length;
+
+  _pos = _start;
+  _ahead = 0;
+  _announce = true;
+
+  read_ahead();
+}
+
+bool file_mmap_source_c::seek( long seek_point, int whence )
+{
+  boost::mutex::scoped_lock lock( _pos_mutex );
+
+  int64_t pos;
+
+  switch ( whence ) {
+  case SEEK_SET: pos = int64_t(_start) + seek_point; break;
+  case SEEK_CUR: pos = int64_t(_pos) + seek_point; break;
+  case SEEK_END: pos = int64_t(_end) + seek_point; break;
+  default:
+    return false;
+  }
+
+  if ( pos < int64_t(_start) || pos >= int64_t(_end) )
+    return false;
+
+  /* nothing to skip over, the next work() simply reads from elsewhere */
+  _pos = pos;
+  _ahead = 0;
+  _announce = true;
+
+  read_ahead();
+
+  return true;
+}
+
+void file_mmap_source_c::set_pacing( double rate )
+{
+  boost::mutex::scoped_lock lock( _pacer_mutex );
+
+  _pacer.set_rate( rate );
+}
+
+void file_mmap_source_c::tag_all( uint64_t offset,
+                                  const pmt::pmt_t &key, const pmt::pmt_t &value )
+{
+  for ( size_t chan = 0; chan < _nchan; chan++ )
+    add_item_tag( chan, offset, key, value );
+}
+
+static bool capture_starts_before( uint64_t pos, const sigmf_capture_t &capture )
+{
+  return pos < capture.sample_start;
+}
+
+static bool capture_starts_after( const sigmf_capture_t &capture, uint64_t pos )
+{
+  return capture.sample_start < pos;
+}
+
+static bool annotation_starts_after( const sigmf_annotation_t &annotation, uint64_t pos )
+{
+  return annotation.sample_start < pos;
+}
+
+void file_mmap_source_c::tag_capture( const sigmf_capture_t &capture,
+                                      uint64_t pos, uint64_t offset )
+{
+  tag_all( offset, pmt::pmt_string_to_symbol("rx_freq"),
+           pmt::pmt_from_double( capture.frequency ) );
+
+  if ( ! capture.has_time )
+    return;
+
+  /* time of the sample at pos, which may lie inside the capture */
+  double elapsed = 0;
+  if ( _meta.sample_rate > 0 )
+    elapsed = (pos - capture.sample_start) / _meta.sample_rate;
+
+  double frac = capture.frac_secs + elapsed;
+  uint64_t full = capture.full_secs + uint64_t(frac);
+  frac -= uint64_t(frac);
+
+  tag_all( offset, pmt::pmt_string_to_symbol("rx_time"),
+           pmt::pmt_make_tuple( pmt::pmt_from_uint64( full ),
+                                pmt::pmt_from_double( frac ) ) );
+}
+
+void file_mmap_source_c::tag_range( uint64_t pos, size_t count, uint64_t offset )
+{
+  const std::vector< sigmf_capture_t > &captures = _meta.captures;
+  const std::vector< sigmf_annotation_t > &annotations = _meta.annotations;
+
+  std::vector< sigmf_capture_t >::const_iterator cap;
+
+  if ( _announce ) {
+    tag_all( offset, pmt::pmt_string_to_symbol("rx_rate"),
+             pmt::pmt_from_double( _meta.sample_rate ) );
+
+    /* the capture we're in the middle of */
+    cap = std::upper_bound( captures.begin(), captures.end(), pos,
+                            capture_starts_before );
+    if ( cap != captures.begin() )
+      tag_capture( *(cap - 1), pos, offset );
+
+    _announce = false;
+  } else {
+    cap = std::lower_bound( captures.begin(), captures.end(), pos,
+                            capture_starts_after );
+  }
+
+  std::vector< sigmf_annotation_t >::const_iterator ann =
+    std::lower_bound( annotations.begin(), annotations.end(), pos,
+                      annotation_starts_after );
+
+  /* captures and annotations beginning within this chunk, in stream order */
+  while ( true ) {
+    bool have_cap = cap != captures.end() && cap->sample_start < pos + count;
+    bool have_ann = ann != annotations.end() && ann->sample_start < pos + count;
+
+    if ( have_cap && ( ! have_ann || cap->sample_start <= ann->sample_start ) ) {
+      tag_capture( *cap, cap->sample_start,
+                   offset + (cap->sample_start - pos) );
+      ++cap;
+    } else if ( have_ann ) {
+      tag_all( offset + (ann->sample_start - pos),
+               pmt::pmt_string_to_symbol("annotation"),
+               pmt::pmt_make_tuple( pmt::pmt_from_uint64( ann->sample_count ),
+                                    pmt::pmt_string_to_symbol( ann->label ) ) );
+      ++ann;
+    } else {
+      break;
+    }
+  }
+}
+
+int file_mmap_source_c::work( int noutput_items,
+                              gr_vector_const_void_star &input_items,
+                              gr_vector_void_star &output_items )
+{
+  int produced = 0;
+
+  boost::mutex::scoped_lock pace_lock( _pacer_mutex );
+
+  /* sleep before taking _pos_mutex, seek() shouldn't have to wait for us */
+  if ( _pacer.get_rate() > 0 )
+    noutput_items = _pacer.wait( noutput_items );
+
+  boost::mutex::scoped_lock lock( _pos_mutex );
+
+  while ( produced < noutput_items ) {
+    if ( _pos >= _end ) {
+      if ( ! _repeat )
+        break;
+
+      _pos = _start;
+      _ahead = 0;
+      _announce = true;
+    }
+
+    size_t count = std::min( size_t(noutput_items - produced), _end - _pos );
+
+    if ( _have_meta )
+      tag_range( _pos, count, nitems_written(0) + produced );
+
+    if ( _interleaved ) {
+      if ( _conv.size() < count * _nchan )
+        _conv.resize( count * _nchan );
+
+      convert_to_cf32( _format, _maps[0].map + _pos * _stride,
+                       &_conv[0], count * _nchan );
+
+      for ( size_t chan = 0; chan < _nchan; chan++ ) {
+        gr_complex *out = (gr_complex *)output_items[chan] + produced;
+        for ( size_t i = 0; i < count; i++ )
+          out[i] = _conv[i * _nchan + chan];
+      }
+    } else {
+      for ( size_t chan = 0; chan < _nchan; chan++ )
+        convert_to_cf32( _format, _maps[chan].map + _pos * _stride,
+                         (gr_complex *)output_items[chan] + produced, count );
+    }
+
+    produced += count;
+    _pos += count;
+
+    read_ahead();
+  }
+
+  _pacer.done( produced );
+
+  if ( 0 == produced )
+    return WORK_DONE;
+
+  return produced;
+}
@@ -0,0 +1,139 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2013 Dimitri Stolnikov <horiz0n@gmx.net>
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef INCLUDED_FILE_MMAP_SOURCE_C_H
+#define INCLUDED_FILE_MMAP_SOURCE_C_H
+
+#include <gr_sync_block.h>
+
+#include <gruel/pmt.h>
+#include <boost/thread/mutex.hpp>
+
+#include "osmosdr_convert.h"
+#include "sigmf_meta.h"
+#include "file_pacer.h"
+
+class file_mmap_source_c;
+
+typedef boost::shared_ptr<file_mmap_source_c> file_mmap_source_c_sptr;
+
+/*!
+ * With more than one file name, every file feeds one output channel.
+ * A single file with nchan > 1 holds sample interleaved channels.
+ */
+file_mmap_source_c_sptr make_file_mmap_source_c( const std::vector< std::string > &filenames,
+                                                  bool repeat,
+                                                  osmosdr_format_t format = OSMOSDR_FORMAT_CF32,
+                                                  size_t nchan = 1 );
+
+/*!
+ * \brief Reads complex samples from memory mapped files.
+ * \ingroup block
+ *
+ * In contrast to gr_file_source, which freads into a private buffer and
+ * copies from there, samples are copied straight from the page cache into
+ * the output buffer. The kernel is told about the sequential access pattern
+ * and the pages ahead of the read position are prefetched.
+ *
+ * Raw integer formats are converted straight from the mapping as well.
+ *
+ * When metadata is attached, rx_rate, rx_freq and rx_time stream tags are
+ * emitted at the start of playback, at every capture boundary and after
+ * wrapping around. Annotations are passed on as "annotation" tags carrying
+ * a (sample count, label) tuple.
+ *
+ * Playback may be limited to a range of the file, and the read position can
+ * be moved at runtime without touching the samples in between.
+ *
+ * All channels are produced by the same work() call and thus can't drift
+ * apart. When pacing is enabled, samples are released in small chunks
+ * against an absolute schedule derived from the monotonic clock, so timing
+ * errors don't accumulate the way they do with chained throttles.
+ */
+class file_mmap_source_c : public gr_sync_block
+{
+private:
+  friend file_mmap_source_c_sptr make_file_mmap_source_c( const std::vector< std::string > &filenames,
+                                                          bool repeat,
+                                                          osmosdr_format_t format,
+                                                          size_t nchan );
+
+  file_mmap_source_c( const std::vector< std::string > &filenames, bool repeat,
+                      osmosdr_format_t format, size_t nchan );
+
+public:
+  ~file_mmap_source_c();
+
+  int work( int noutput_items,
+            gr_vector_const_void_star &input_items,
+            gr_vector_void_star &output_items );
+
+  void set_metadata( const sigmf_meta_t &meta );
+
+  /* limits playback to length samples starting at start, 0 means up to EOF */
+  void set_range( uint64_t start, uint64_t length );
+
+  /* position in samples within the playback window of set_range(), like fseek */
+  bool seek( long seek_point, int whence );
+
+  /* release samples in real time at the given rate, 0 disables pacing */
+  void set_pacing( double rate );
+
+  uint64_t get_num_samples() { return _nsamples; }
+
+private:
+  struct mapping_t {
+    int fd;
+    const unsigned char *map;
+    size_t len;
+  };
+
+  void map_file( const std::string &filename );
+  void unmap_all();
+  void read_ahead();
+  void tag_capture( const sigmf_capture_t &capture, uint64_t pos, uint64_t offset );
+  void tag_range( uint64_t pos, size_t count, uint64_t offset );
+  void tag_all( uint64_t offset, const pmt::pmt_t &key, const pmt::pmt_t &value );
+
+  std::vector< mapping_t > _maps;
+  size_t _nchan;
+  bool _interleaved;    /* all channels in one file */
+
+  osmosdr_format_t _format;
+  size_t _sample_size;
+  size_t _stride;       /* bytes from one sample to the next within a file */
+  std::vector< gr_complex > _conv;
+
+  size_t _nsamples;     /* number of complete samples per channel */
+  size_t _pos;          /* read position in samples */
+  size_t _start, _end;  /* playback range in samples */
+  size_t _ahead;        /* byte offset up to which we requested read-ahead */
+  bool _repeat;
+
+  bool _have_meta;
+  sigmf_meta_t _meta;
+  bool _announce;       /* tag the full state at the next sample */
+
+  boost::mutex _pos_mutex;
+
+  file_pacer _pacer;
+  boost::mutex _pacer_mutex;
+};
+
+#endif /* INCLUDED_FILE_MMAP_SOURCE_C_H */
@@ -0,0 +1,105 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2013 Dimitri Stolnikov <horiz0n@gmx.net>
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef FILE_PACER_H
+#define FILE_PACER_H
+
+#include <algorithm>
+#include <stdint.h>
+#include <time.h>
+
+#include <boost/thread/thread.hpp>
+
+/*!
+ * Paces a sample stream to real time.
+ *
+ * Samples are let through in chunks of quantum seconds against an absolute
+ * schedule derived from the monotonic clock, so that sleep inaccuracies
+ * don't accumulate. When the stream falls more than max_lag seconds behind,
+ * the schedule is moved instead of catching up in one burst, and the slip
+ * is counted.
+ */
+class file_pacer
+{
+public:
+  file_pacer( double quantum, double max_lag )
+    : _quantum(quantum), _max_lag(max_lag),
+      _rate(0), _chunk(0), _started(false), _t0(0), _done(0), _slips(0)
+  {
+  }
+
+  void set_rate( double rate )
+  {
+    _rate = rate;
+    _chunk = std::max< size_t >( 1, size_t(rate * _quantum) );
+    _started = false;
+  }
+
+  double get_rate() { return _rate; }
+
+  /* waits until the next chunk is due, returns how many samples it holds */
+  size_t wait( size_t nitems )
+  {
+    double now = monotonic_time();
+
+    if ( ! _started ) {
+      _t0 = now;
+      _done = 0;
+      _started = true;
+    }
+
+    size_t count = std::min( nitems, _chunk );
+
+    /* when the last sample of the chunk is due */
+    double due = _t0 + (_done + count) / _rate;
+
+    if ( now - due > _max_lag ) {
+      _t0 = now - (_done + count) / _rate;
+      _slips++;
+    } else if ( due > now ) {
+      boost::this_thread::sleep( boost::posix_time::microseconds( long((due - now) * 1e6) ) );
+    }
+
+    return count;
+  }
+
+  /* accounts for the samples actually passed on after wait() */
+  void done( size_t nitems ) { _done += nitems; }
+
+  uint64_t slips() { return _slips; }
+
+  static double monotonic_time()
+  {
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+  }
+
+private:
+  double _quantum;
+  double _max_lag;
+  double _rate;
+  size_t _chunk;
+  bool _started;
+  double _t0;           /* monotonic time the schedule is anchored at */
+  uint64_t _done;       /* samples passed since _t0 */
+  uint64_t _slips;
+};
+
+#endif // FILE_PACER_H
@@ -0,0 +1,319 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2013 Dimitri Stolnikov <horiz0n@gmx.net>
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <iostream>
+#include <stdexcept>
+#include <string.h>
+#include <errno.h>
+
+#include <boost/assign.hpp>
+
+#include <gr_io_signature.h>
+
+#include "file_sink_c.h"
+
+#include <osmosdr_arg_helpers.h>
+
+#define PACE_QUANTUM 0.001  /* seconds of samples consumed per wakeup */
+#define PACE_MAX_LAG 0.01   /* falling further behind than this is an underrun */
+
+#define FILE_BUFFER_SIZE (1024 * 1024)
+
+using namespace boost::assign;
+
+file_sink_c_sptr make_file_sink_c( const std::string &args )
+{
+  return gnuradio::get_initial_sptr(new file_sink_c(args));
+}
+
+file_sink_c::file_sink_c( const std::string &args )
+  : gr_sync_block( "file_sink_c",
+                   gr_make_io_signature( 1, 1, sizeof(gr_complex) ),
+                   gr_make_io_signature( 0, 0, 0 ) ),
+    _fp(NULL),
+    _format(OSMOSDR_FORMAT_CF32),
+    _freq(0),
+    _rate(0),
+    _throttle(true),
+    _pacer(PACE_QUANTUM, PACE_MAX_LAG),
+    _start_time(0),
+    _stop_time(0),
+    _samples(0),
+    _underruns(0)
+{
+  bool append = false;
+
+  dict_t dict = params_to_dict(args);
+
+  if (dict.count("file"))
+    _filename = dict["file"];
+
+  if (dict.count("freq"))
+    _freq = boost::lexical_cast< double >( dict["freq"] );
+
+  if (dict.count("rate"))
+    _rate = boost::lexical_cast< double >( dict["rate"] );
+
+  if (dict.count("throttle"))
+    _throttle = ("true" == dict["throttle"] ? true : false);
+
+  if (dict.count("append"))
+    append = ("true" == dict["append"] ? true : false);
+
+  if (dict.count("format"))
+    _format = string_to_format( dict["format"] );
+
+  if ( _filename.empty() )
+    throw std::runtime_error( "No file name given, use file=<path>." );
+
+  _fp = fopen( _filename.c_str(), append ? "ab" : "wb" );
+  if ( ! _fp )
+    throw std::runtime_error( "Failed to open '" + _filename + "' for writing: " +
+                              strerror(errno) );
+
+  setvbuf( _fp, NULL, _IOFBF, FILE_BUFFER_SIZE );
+
+  if ( _throttle && _rate > 0 )
+    _pacer.set_rate( _rate );
+
+  std::cerr << "Writing " << format_to_string( _format )
+            << " samples to " << _filename;
+  if ( _throttle )
+    std::cerr << ", paced at the sample rate";
+  std::cerr << "." << std::endl;
+}
+
+file_sink_c::~file_sink_c()
+{
+  if ( _fp )
+    fclose( _fp );
+}
+
+bool file_sink_c::start()
+{
+  boost::mutex::scoped_lock lock( _pacer_mutex );
+
+  _samples = 0;
+  _underruns = 0;
+  _start_time = file_pacer::monotonic_time();
+  _stop_time = 0;
+
+  /* restart the schedule, the time before start() doesn't count */
+  if ( _throttle && _rate > 0 )
+    _pacer.set_rate( _rate );
+
+  return true;
+}
+
+bool file_sink_c::stop()
+{
+  _stop_time = file_pacer::monotonic_time();
+
+  if ( _fp )
+    fflush( _fp );
+
+  print_stats();
+
+  return true;
+}
+
+void file_sink_c::print_stats()
+{
+  double elapsed = _stop_time - _start_time;
+
+  std::cerr << "Wrote " << _samples << " samples to " << _filename;
+  if ( elapsed > 0 )
+    std::cerr << " in " << elapsed << " s ("
+              << _samples / elapsed / 1e6 << " Msps)";
+  if ( _throttle )
+    std::cerr << ", " << _underruns << " underrun(s)";
+  std::cerr << "." << std::endl;
+}
+
+int file_sink_c::work( int noutput_items,
+                       gr_vector_const_void_star &input_items,
+                       gr_vector_void_star &output_items )
+{
+  const gr_complex *in = (const gr_complex *) input_items[0];
+
+  {
+    boost::mutex::scoped_lock lock( _pacer_mutex );
+
+    if ( _throttle && _pacer.get_rate() > 0 ) {
+      uint64_t slips = _pacer.slips();
+
+      noutput_items = _pacer.wait( noutput_items );
+
+      /* we've been starved longer than a device would tolerate */
+      if ( _pacer.slips() != slips ) {
+        _underruns++;
+        std::cerr << "U" << std::flush;
+      }
+
+      _pacer.done( noutput_items );
+    }
+  }
+
+  const void *data = in;
+
+  if ( _format != OSMOSDR_FORMAT_CF32 ) {
+    size_t bytes = noutput_items * format_sample_size( _format );
+    if ( _conv.size() < bytes )
+      _conv.resize( bytes );
+
+    convert_from_cf32( _format, in, &_conv[0], noutput_items );
+    data = &_conv[0];
+  }
+
+  if ( fwrite( data, format_sample_size( _format ), noutput_items, _fp )
+       != (size_t)noutput_items ) {
+    std::cerr << "Failed to write to " << _filename << ": "
+              << strerror(errno) << std::endl;
+    return WORK_DONE;
+  }
+
+  _samples += noutput_items;
+
+  return noutput_items;
+}
+
+std::vector<std::string> file_sink_c::get_devices()
+{
+  std::vector<std::string> devices;
+
+  std::string args = "file='/path/to/your/file',rate=1e6,freq=100e6,format=cf32,throttle=true";
+  args += ",label='Complex Sampled (IQ) File'";
+  devices.push_back( args );
+
+  return devices;
+}
+
+size_t file_sink_c::get_num_channels( void )
+{
+  return 1;
+}
+
+osmosdr::meta_range_t file_sink_c::get_sample_rates( void )
+{
+  osmosdr::meta_range_t range;
+
+  /* a file takes whatever rate it is given */
+  range += osmosdr::range_t( 1, 100e6 );
+
+  return range;
+}
+
+double file_sink_c::set_sample_rate( double rate )
+{
+  boost::mutex::scoped_lock lock( _pacer_mutex );
+
+  _rate = rate;
+
+  if ( _throttle && _rate > 0 )
+    _pacer.set_rate( _rate );
+
+  return get_sample_rate();
+}
+
+double file_sink_c::get_sample_rate( void )
+{
+  return _rate;
+}
+
+osmosdr::freq_range_t file_sink_c::get_freq_range( size_t chan )
+{
+  return osmosdr::freq_range_t( 0, 100e9 );
+}
+
+double file_sink_c::set_center_freq( double freq, size_t chan )
+{
+  _freq = freq;
+
+  return get_center_freq(chan);
+}
+
+double file_sink_c::get_center_freq( size_t chan )
+{
+  return _freq;
+}
+
+double file_sink_c::set_freq_corr( double ppm, size_t chan )
+{
+  return get_freq_corr( chan );
+}
+
+double file_sink_c::get_freq_corr( size_t chan )
+{
+  return 0;
+}
+
+std::vector<std::string> file_sink_c::get_gain_names( size_t chan )
+{
+  return std::vector< std::string >();
+}
+
+osmosdr::gain_range_t file_sink_c::get_gain_range( size_t chan )
+{
+  return osmosdr::gain_range_t();
+}
+
+osmosdr::gain_range_t file_sink_c::get_gain_range( const std::string & name, size_t chan )
+{
+  return get_gain_range( chan );
+}
+
+double file_sink_c::set_gain( double gain, size_t chan )
+{
+  return get_gain(chan);
+}
+
+double file_sink_c::set_gain( double gain, const std::string & name, size_t chan )
+{
+  return set_gain(gain, chan);
+}
+
+double file_sink_c::get_gain( size_t chan )
+{
+  return 0;
+}
+
+double file_sink_c::get_gain( const std::string & name, size_t chan )
+{
+  return get_gain(chan);
+}
+
+std::vector< std::string > file_sink_c::get_antennas( size_t chan )
+{
+  return std::vector< std::string >();
+}
+
+std::string file_sink_c::set_antenna( const std::string & antenna, size_t chan )
+{
+  return get_antenna(chan);
+}
+
+std::string file_sink_c::get_antenna( size_t chan )
+{
+  return "";
+}
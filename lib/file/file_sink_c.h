@@ -0,0 +1,114 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2013 Dimitri Stolnikov <horiz0n@gmx.net>
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef FILE_SINK_C_H
+#define FILE_SINK_C_H
+
+#include <stdio.h>
+
+#include <gr_sync_block.h>
+
+#include <boost/thread/mutex.hpp>
+
+#include "osmosdr_snk_iface.h"
+#include "osmosdr_convert.h"
+#include "file_pacer.h"
+
+class file_sink_c;
+
+typedef boost::shared_ptr< file_sink_c > file_sink_c_sptr;
+
+file_sink_c_sptr make_file_sink_c( const std::string & args = "" );
+
+/*!
+ * \brief Writes the transmit stream to a file instead of a radio.
+ * \ingroup block
+ *
+ * Samples are stored in the selected raw format and, unless disabled, are
+ * consumed at the configured sample rate like a real device would. When the
+ * flowgraph can't keep up, a "U" is printed and the underrun counted.
+ * Throughput and underrun statistics are reported when the flowgraph stops.
+ */
+class file_sink_c :
+    public gr_sync_block,
+    public osmosdr_snk_iface
+{
+private:
+  friend file_sink_c_sptr make_file_sink_c(const std::string &args);
+
+  file_sink_c(const std::string &args);
+
+public:
+  ~file_sink_c();
+
+  bool start();
+  bool stop();
+
+  int work( int noutput_items,
+            gr_vector_const_void_star &input_items,
+            gr_vector_void_star &output_items );
+
+  static std::vector< std::string > get_devices();
+
+  size_t get_num_channels( void );
+
+  osmosdr::meta_range_t get_sample_rates( void );
+  double set_sample_rate( double rate );
+  double get_sample_rate( void );
+
+  osmosdr::freq_range_t get_freq_range( size_t chan = 0 );
+  double set_center_freq( double freq, size_t chan = 0 );
+  double get_center_freq( size_t chan = 0 );
+  double set_freq_corr( double ppm, size_t chan = 0 );
+  double get_freq_corr( size_t chan = 0 );
+
+  std::vector<std::string> get_gain_names( size_t chan = 0 );
+  osmosdr::gain_range_t get_gain_range( size_t chan = 0 );
+  osmosdr::gain_range_t get_gain_range( const std::string & name, size_t chan = 0 );
+  double set_gain( double gain, size_t chan = 0 );
+  double set_gain( double gain, const std::string & name, size_t chan = 0 );
+  double get_gain( size_t chan = 0 );
+  double get_gain( const std::string & name, size_t chan = 0 );
+
+  std::vector< std::string > get_antennas( size_t chan = 0 );
+  std::string set_antenna( const std::string & antenna, size_t chan = 0 );
+  std::string get_antenna( size_t chan = 0 );
+
+private:
+  void print_stats();
+
+  FILE *_fp;
+  std::string _filename;
+  osmosdr_format_t _format;
+  std::vector< unsigned char > _conv;
+
+  double _freq, _rate;
+  bool _throttle;
+
+  file_pacer _pacer;
+  boost::mutex _pacer_mutex;
+
+  /* statistics */
+  double _start_time;
+  double _stop_time;
+  uint64_t _samples;
+  uint64_t _underruns;
+};
+
+#endif // FILE_SINK_C_H
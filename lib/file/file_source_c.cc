@@ -19,21 +19,58 @@
  */
 
 #include <fstream>
+#include <iostream>
 #include <string>
 #include <sstream>
 
 #include <boost/assign.hpp>
+#include <boost/algorithm/string.hpp>
 
 #include <gr_io_signature.h>
 #include <gr_file_source.h>
 #include <gr_throttle.h>
 
+#ifdef HAVE_MMAP
+#include <sys/stat.h>
+#endif
+
 #include "file_source_c.h"
+#include "sigmf_meta.h"
 
 #include <osmosdr_arg_helpers.h>
+#include <osmosdr_convert.h>
 
 using namespace boost::assign;
 
+/* a position given in samples, or in seconds when suffixed with 's' */
+static uint64_t parse_position( const std::string &value, double rate )
+{
+  if ( value.length() && 's' == value[value.length() - 1] ) {
+    double secs = boost::lexical_cast< double >( value.substr( 0, value.length() - 1 ) );
+    if ( secs < 0 )
+      throw std::runtime_error( "Negative position '" + value + "'." );
+
+    return uint64_t( secs * rate + 0.5 );
+  }
+
+  double samples = boost::lexical_cast< double >( value );
+  if ( samples < 0 )
+    throw std::runtime_error( "Negative position '" + value + "'." );
+
+  return uint64_t( samples );
+}
+
+static size_t args_to_nchan( const std::string &args )
+{
+  dict_t dict = params_to_dict(args);
+
+  size_t nchan = 1;
+  if (dict.count("nchan"))
+    nchan = boost::lexical_cast< size_t >( dict["nchan"] );
+
+  return std::max< size_t >( nchan, 1 );
+}
+
 file_source_c_sptr make_file_source_c(const std::string &args)
 {
   return gnuradio::get_initial_sptr(new file_source_c(args));
@@ -42,11 +79,17 @@ file_source_c_sptr make_file_source_c(const std::string &args)
 file_source_c::file_source_c(const std::string &args) :
   gr_hier_block2("file_source_c",
                  gr_make_io_signature (0, 0, 0),
-                 gr_make_io_signature (1, 1, sizeof (gr_complex)))
+                 gr_make_io_signature (args_to_nchan(args),
+                                       args_to_nchan(args),
+                                       sizeof (gr_complex))),
+  _nchan(args_to_nchan(args))
 {
   std::string filename;
+  std::string meta_filename;
   bool repeat = true;
   bool throttle = true;
+  bool use_mmap = true;
+  osmosdr_format_t format = OSMOSDR_FORMAT_CF32;
   _freq = 0;
   _rate = 0;
 
@@ -55,6 +98,9 @@ file_source_c::file_source_c(const std::string &args) :
   if (dict.count("file"))
     filename = dict["file"];
 
+  if (dict.count("meta"))
+    meta_filename = dict["meta"];
+
   if (dict.count("freq"))
     _freq = boost::lexical_cast< double >( dict["freq"] );
 
@@ -67,6 +113,49 @@ file_source_c::file_source_c(const std::string &args) :
   if (dict.count("throttle"))
     throttle = ("true" == dict["throttle"] ? true : false);
 
+  if (dict.count("format"))
+    format = string_to_format( dict["format"] );
+
+  /* several recordings may be given, separated by semicolons */
+  bool single_file = ( filename.find(';') == std::string::npos );
+
+  /* file= may point to the metadata, the recording lives next to it */
+  if ( meta_filename.empty() && single_file &&
+       sigmf_data_filename( filename ).length() ) {
+    meta_filename = filename;
+    filename = sigmf_data_filename( meta_filename );
+  }
+
+  if ( meta_filename.empty() && single_file && filename.length() &&
+       std::ifstream( sigmf_meta_filename( filename ).c_str() ).good() )
+    meta_filename = sigmf_meta_filename( filename );
+
+  sigmf_meta_t meta;
+
+  if ( meta_filename.length() ) {
+    meta = sigmf_read_meta( meta_filename );
+
+    /* explicitly given arguments take precedence over the metadata */
+    if ( dict.count("format") && format != meta.format )
+      std::cerr << "Using format " << format_to_string( format )
+                << " instead of " << format_to_string( meta.format )
+                << " from " << meta_filename << std::endl;
+    else
+      format = meta.format;
+
+    if ( _rate != 0 && meta.sample_rate != 0 && _rate != meta.sample_rate )
+      std::cerr << "Using rate " << _rate << " instead of "
+                << meta.sample_rate << " from " << meta_filename << std::endl;
+    else if ( 0 == _rate )
+      _rate = meta.sample_rate;
+
+    if ( ! dict.count("freq") && meta.captures.size() )
+      _freq = meta.captures.front().frequency;
+  }
+
+  if (dict.count("mmap"))
+    use_mmap = ("true" == dict["mmap"] ? true : false);
+
   if (!filename.length())
     throw std::runtime_error("No file name specified.");
 
@@ -76,17 +165,113 @@ file_source_c::file_source_c(const std::string &args) :
   if (0 == _rate)
     throw std::runtime_error("Parameter 'rate' is missing in arguments.");
 
-  gr_file_source_sptr src = gr_make_file_source( sizeof(gr_complex),
-                                                 filename.c_str(),
-                                                 repeat );
+  meta.format = format;
+  meta.sample_rate = _rate;
+
+  if ( meta.captures.empty() ) {
+    sigmf_capture_t capture;
+    capture.sample_start = 0;
+    capture.frequency = _freq;
+    capture.has_time = false;
+    capture.full_secs = 0;
+    capture.frac_secs = 0;
+    meta.captures.push_back( capture );
+  }
+
+  uint64_t offset = 0, length = 0;
+
+  if (dict.count("offset"))
+    offset = parse_position( dict["offset"], _rate );
+
+  if (dict.count("length"))
+    length = parse_position( dict["length"], _rate );
+
+  std::vector< std::string > filenames;
+  boost::algorithm::split( filenames, filename, boost::is_any_of(";") );
+
+  if ( filenames.size() > 1 && filenames.size() != _nchan )
+    throw std::runtime_error("Parameter 'nchan' must match the number of files.");
+
+  gr_basic_block_sptr src;
+
+  if ( filenames.size() == 1 && boost::algorithm::ends_with( filename, ".zst" ) ) {
+#ifdef HAVE_ZSTD
+    /* capture.cs8.zst holds cs8 samples */
+    std::string inner = filename.substr( 0, filename.length() - 4 );
+    size_t dot = inner.find_last_of( '.' );
+    if ( ! dict.count("format") && meta_filename.empty() &&
+         dot != std::string::npos ) {
+      std::string ext = inner.substr( dot + 1 );
+      if ( "cu8" == ext || "cs8" == ext || "cs16" == ext || "cf32" == ext )
+        format = string_to_format( ext );
+    }
+
+    if ( offset || length )
+      throw std::runtime_error( "Parameters 'offset' and 'length' are not supported for compressed files." );
+
+    if ( _nchan > 1 )
+      throw std::runtime_error( "Multichannel playback is not supported for compressed files." );
+
+    size_t nthreads = 0;
+    if (dict.count("threads"))
+      nthreads = boost::lexical_cast< size_t >( dict["threads"] );
+
+    _zstd_src = make_file_zstd_source_c( filename, repeat, format, nthreads );
+
+    if ( throttle )
+      _zstd_src->set_pacing( _rate );
+
+    connect( _zstd_src, 0, self(), 0 );
+
+    return;
+#else
+    throw std::runtime_error( "Compressed files require zstd support, which is not built in." );
+#endif
+  }
+
+#ifdef HAVE_MMAP
+  struct stat st;
+  /* pipes and character devices can't be mapped, read them the usual way */
+  if ( use_mmap && stat( filenames[0].c_str(), &st ) == 0 && S_ISREG(st.st_mode) ) {
+    _mmap_src = make_file_mmap_source_c( filenames, repeat, format, _nchan );
+    _mmap_src->set_metadata( meta );
+
+    if ( offset || length )
+      _mmap_src->set_range( offset, length );
+
+    /* paces all channels at once, more accurately than gr_throttle */
+    if ( throttle )
+      _mmap_src->set_pacing( _rate );
+
+    for ( size_t i = 0; i < _nchan; i++ )
+      connect( _mmap_src, i, self(), i );
+
+    return;
+  }
+#endif
+
+  if ( format != OSMOSDR_FORMAT_CF32 )
+    throw std::runtime_error( "Format '" + format_to_string( format ) +
+                              "' is supported for memory mapped files only." );
+
+  if ( length )
+    throw std::runtime_error( "Parameter 'length' is supported for memory mapped files only." );
+
+  if ( _nchan > 1 )
+    throw std::runtime_error( "Multichannel playback is supported for memory mapped files only." );
+
+  _file_src = gr_make_file_source( sizeof(gr_complex), filename.c_str(), repeat );
+
+  if ( offset && ! _file_src->seek( offset, SEEK_SET ) )
+    throw std::runtime_error( "Failed to seek in '" + filename + "'." );
 
   if (throttle) {
     gr_throttle::sptr throttle = gr_make_throttle( sizeof(gr_complex), _rate );
 
-    connect( src, 0, throttle, 0 );
+    connect( _file_src, 0, throttle, 0 );
     connect( throttle, 0, self(), 0 );
   } else {
-    connect( src, 0, self(), 0 );
+    connect( _file_src, 0, self(), 0 );
   }
 }
 
@@ -103,7 +288,7 @@ std::vector<std::string> file_source_c::get_devices()
 {
   std::vector<std::string> devices;
 
-  std::string args = "file='/path/to/your/file',rate=1e6,freq=100e6,repeat=true,throttle=true";
+  std::string args = "file='/path/to/your/file',rate=1e6,freq=100e6,format=cf32,repeat=true,throttle=true";
   args += ",label='Complex Sampled (IQ) File'";
   devices.push_back( args );
 
@@ -112,7 +297,7 @@ std::vector<std::string> file_source_c::get_devices()
 
 size_t file_source_c::get_num_channels( void )
 {
-  return 1;
+  return _nchan;
 }
 
 osmosdr::meta_range_t file_source_c::get_sample_rates( void )
@@ -208,3 +393,16 @@ std::string file_source_c::get_antenna( size_t chan )
 {
   return "";
 }
+
+bool file_source_c::seek( long seek_point, int whence, size_t chan )
+{
+#ifdef HAVE_MMAP
+  if ( _mmap_src )
+    return _mmap_src->seek( seek_point, whence );
+#endif
+
+  if ( _file_src )
+    return _file_src->seek( seek_point, whence );
+
+  return false;
+}
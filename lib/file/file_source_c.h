@@ -21,9 +21,18 @@
 #define FILE_SOURCE_C_H
 
 #include <gr_hier_block2.h>
+#include <gr_file_source.h>
 
 #include "osmosdr_src_iface.h"
 
+#ifdef HAVE_MMAP
+#include "file_mmap_source_c.h"
+#endif
+
+#ifdef HAVE_ZSTD
+#include "file_zstd_source_c.h"
+#endif
+
 class file_source_c;
 
 typedef boost::shared_ptr< file_source_c > file_source_c_sptr;
@@ -70,8 +79,19 @@ public:
   std::string set_antenna( const std::string & antenna, size_t chan = 0 );
   std::string get_antenna( size_t chan = 0 );
 
+  bool seek( long seek_point, int whence, size_t chan = 0 );
+
 private:
+  size_t _nchan;
   double _freq, _rate;
+
+  gr_file_source_sptr _file_src;
+#ifdef HAVE_MMAP
+  file_mmap_source_c_sptr _mmap_src;
+#endif
+#ifdef HAVE_ZSTD
+  file_zstd_source_c_sptr _zstd_src;
+#endif
 };
 
 #endif // FILE_SOURCE_C_H
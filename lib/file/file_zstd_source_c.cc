@@ -0,0 +1,334 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2013 Dimitri Stolnikov <horiz0n@gmx.net>
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "file_zstd_source_c.h"
+#include <gr_io_signature.h>
+
+#include <stdexcept>
+#include <iostream>
+#include <algorithm>
+#include <string.h>
+#include <errno.h>
+
+#include <boost/bind.hpp>
+
+#include <zstd.h>
+
+#define READ_SIZE      (4 * 1024 * 1024)   /* initial size of the read buffer */
+#define MAX_FRAME_SIZE (64 * 1024 * 1024)  /* largest compressed frame we accept */
+#define MAX_CONTENT    (256 * 1024 * 1024) /* largest decompressed frame we accept */
+#define PACE_QUANTUM   0.001 /* seconds worth of samples released at once */
+#define PACE_MAX_LAG   0.1   /* seconds behind schedule before we give up catching up */
+
+file_zstd_source_c_sptr make_file_zstd_source_c( const std::string &filename,
+                                                 bool repeat,
+                                                 osmosdr_format_t format,
+                                                 size_t nthreads )
+{
+  return gnuradio::get_initial_sptr(new file_zstd_source_c(filename, repeat,
+                                                           format, nthreads));
+}
+
+file_zstd_source_c::file_zstd_source_c( const std::string &filename,
+                                        bool repeat,
+                                        osmosdr_format_t format,
+                                        size_t nthreads )
+  : gr_sync_block( "file_zstd_source_c",
+                   gr_make_io_signature( 0, 0, 0 ),
+                   gr_make_io_signature( 1, 1, sizeof(gr_complex) ) ),
+    _fp(NULL),
+    _filename(filename),
+    _repeat(repeat),
+    _format(format),
+    _in(READ_SIZE),
+    _in_pos(0),
+    _in_len(0),
+    _in_eof(false),
+    _offset(0),
+    _eof(false),
+    _running(true),
+    _pacer(PACE_QUANTUM, PACE_MAX_LAG)
+{
+  _fp = fopen( filename.c_str(), "rb" );
+  if ( ! _fp )
+    throw std::runtime_error( "Failed to open '" + filename + "': " +
+                              strerror(errno) );
+
+  if ( 0 == nthreads )
+    nthreads = std::max< size_t >( 1, boost::thread::hardware_concurrency() );
+
+  /* enough to keep every decoder busy while work() drains the front */
+  _max_frames = 2 * nthreads + 2;
+
+  std::cerr << "Decoding " << filename << " with " << nthreads
+            << " thread(s)." << std::endl;
+
+  _threads.create_thread( boost::bind( &file_zstd_source_c::reader, this ) );
+
+  for ( size_t i = 0; i < nthreads; i++ )
+    _threads.create_thread( boost::bind( &file_zstd_source_c::decoder, this ) );
+}
+
+file_zstd_source_c::~file_zstd_source_c()
+{
+  {
+    boost::mutex::scoped_lock lock( _mutex );
+    _running = false;
+  }
+
+  _frame_pending.notify_all();
+  _frame_done.notify_all();
+  _frame_ready.notify_all();
+
+  _threads.join_all();
+
+  fclose( _fp );
+}
+
+void file_zstd_source_c::set_pacing( double rate )
+{
+  boost::mutex::scoped_lock lock( _pacer_mutex );
+
+  _pacer.set_rate( rate );
+}
+
+/* returns false at the end of the file */
+bool file_zstd_source_c::read_frame( std::vector< unsigned char > &frame )
+{
+  while ( true ) {
+    size_t avail = _in_len - _in_pos;
+    const unsigned char *p = &_in[0] + _in_pos;
+
+    if ( avail ) {
+      size_t size = ZSTD_findFrameCompressedSize( p, avail );
+      if ( ! ZSTD_isError( size ) ) {
+        frame.assign( p, p + size );
+        _in_pos += size;
+        return true;
+      }
+
+      if ( _in_eof )
+        throw std::runtime_error( "Truncated or corrupt zstd frame in '" +
+                                  _filename + "'." );
+    } else if ( _in_eof ) {
+      return false;
+    }
+
+    /* the frame continues beyond what we have, read more */
+    memmove( &_in[0], p, avail );
+    _in_pos = 0;
+    _in_len = avail;
+
+    if ( _in_len == _in.size() ) {
+      if ( _in.size() >= MAX_FRAME_SIZE )
+        throw std::runtime_error( "Corrupt or oversized zstd frame in '" +
+                                  _filename + "'." );
+      _in.resize( _in.size() * 2 );
+    }
+
+    size_t n = fread( &_in[0] + _in_len, 1, _in.size() - _in_len, _fp );
+    if ( 0 == n ) {
+      if ( ferror( _fp ) )
+        throw std::runtime_error( "Failed to read '" + _filename + "': " +
+                                  strerror(errno) );
+      _in_eof = true;
+    }
+
+    _in_len += n;
+  }
+}
+
+void file_zstd_source_c::reader()
+{
+  bool any = false; /* frames found in this pass over the file */
+
+  while ( true ) {
+    frame_sptr frame( new frame_t );
+    frame->ready = false;
+
+    try {
+      if ( ! read_frame( frame->data ) ) {
+        if ( _repeat && any ) {
+          fseek( _fp, 0, SEEK_SET );
+          _in_pos = _in_len = 0;
+          _in_eof = false;
+          any = false;
+          continue;
+        }
+
+        boost::mutex::scoped_lock lock( _mutex );
+        _eof = true;
+        _frame_ready.notify_all();
+        return;
+      }
+    } catch ( std::exception &ex ) {
+      /* handed to work() in order, playback stops there */
+      frame->error = ex.what();
+      frame->ready = true;
+    }
+
+    any = true;
+
+    boost::mutex::scoped_lock lock( _mutex );
+
+    while ( _running && _frames.size() >= _max_frames )
+      _frame_done.wait( lock );
+
+    if ( ! _running )
+      return;
+
+    _frames.push_back( frame );
+
+    if ( frame->ready ) {
+      _eof = true;
+      _frame_ready.notify_all();
+      return;
+    }
+
+    _pending.push_back( frame );
+    _frame_pending.notify_one();
+  }
+}
+
+void file_zstd_source_c::decoder()
+{
+  ZSTD_DCtx *dctx = ZSTD_createDCtx();
+  std::vector< unsigned char > raw;
+  size_t sample_size = format_sample_size( _format );
+
+  while ( true ) {
+    frame_sptr frame;
+
+    {
+      boost::mutex::scoped_lock lock( _mutex );
+
+      while ( _running && _pending.empty() )
+        _frame_pending.wait( lock );
+
+      if ( ! _running )
+        break;
+
+      frame = _pending.front();
+      _pending.pop_front();
+    }
+
+    std::string error;
+    unsigned long long size =
+      ZSTD_getFrameContentSize( &frame->data[0], frame->data.size() );
+
+    if ( ZSTD_CONTENTSIZE_UNKNOWN == size || ZSTD_CONTENTSIZE_ERROR == size ||
+         size > MAX_CONTENT ) {
+      error = "Unsupported zstd frame in '" + _filename + "', " +
+              "the decompressed size must be given in the frame header.";
+    } else if ( 0 == size ) {
+      /* a skippable frame or an empty one, it's ready without samples */
+    } else {
+      raw.resize( size );
+
+      size_t ret = ZSTD_decompressDCtx( dctx, &raw[0], raw.size(),
+                                        &frame->data[0], frame->data.size() );
+      if ( ZSTD_isError( ret ) ) {
+        error = "Failed to decompress '" + _filename + "': " +
+                ZSTD_getErrorName( ret );
+      } else {
+        size_t count = ret / sample_size;
+
+        frame->samples.resize( count );
+        if ( count )
+          convert_to_cf32( _format, &raw[0], &frame->samples[0], count );
+      }
+    }
+
+    std::vector< unsigned char >().swap( frame->data );
+
+    {
+      boost::mutex::scoped_lock lock( _mutex );
+      frame->error = error;
+      frame->ready = true;
+    }
+    _frame_ready.notify_all();
+  }
+
+  ZSTD_freeDCtx( dctx );
+}
+
+int file_zstd_source_c::work( int noutput_items,
+                              gr_vector_const_void_star &input_items,
+                              gr_vector_void_star &output_items )
+{
+  gr_complex *out = (gr_complex *)output_items[0];
+
+  boost::mutex::scoped_lock pace_lock( _pacer_mutex );
+
+  if ( _pacer.get_rate() > 0 )
+    noutput_items = _pacer.wait( noutput_items );
+
+  int produced = 0;
+
+  {
+    boost::mutex::scoped_lock lock( _mutex );
+
+    while ( produced < noutput_items ) {
+      if ( _frames.empty() || ! _frames.front()->ready ) {
+        /* hand out what we have rather than waiting for the decoders */
+        if ( produced )
+          break;
+
+        if ( _frames.empty() && _eof )
+          return WORK_DONE;
+
+        _frame_ready.wait( lock );
+        continue;
+      }
+
+      frame_sptr frame = _frames.front();
+
+      if ( frame->error.length() ) {
+        if ( produced )
+          break;
+
+        std::cerr << frame->error << std::endl;
+        return WORK_DONE;
+      }
+
+      size_t n = std::min( frame->samples.size() - _offset,
+                           size_t(noutput_items - produced) );
+      if ( n )
+        memcpy( out + produced, &frame->samples[_offset], n * sizeof(gr_complex) );
+
+      produced += n;
+      _offset += n;
+
+      if ( _offset == frame->samples.size() ) {
+        _frames.pop_front();
+        _offset = 0;
+        _frame_done.notify_one();
+      }
+    }
+  }
+
+  _pacer.done( produced );
+
+  return produced;
+}
@@ -0,0 +1,122 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2013 Dimitri Stolnikov <horiz0n@gmx.net>
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef INCLUDED_FILE_ZSTD_SOURCE_C_H
+#define INCLUDED_FILE_ZSTD_SOURCE_C_H
+
+#include <stdio.h>
+#include <deque>
+
+#include <gr_sync_block.h>
+
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <gruel/thread.h>
+
+#include "osmosdr_convert.h"
+#include "file_pacer.h"
+
+class file_zstd_source_c;
+
+typedef boost::shared_ptr<file_zstd_source_c> file_zstd_source_c_sptr;
+
+/*!
+ * nthreads = 0 uses one decoder thread per CPU core.
+ */
+file_zstd_source_c_sptr make_file_zstd_source_c( const std::string &filename,
+                                                  bool repeat,
+                                                  osmosdr_format_t format = OSMOSDR_FORMAT_CF32,
+                                                  size_t nthreads = 0 );
+
+/*!
+ * \brief Reads complex samples from zstd compressed files.
+ * \ingroup block
+ *
+ * The file is expected to be a sequence of independent zstd frames, each
+ * carrying its decompressed size in the frame header. This is what the
+ * recorder writes and what the zstd tool produces for regular input files.
+ *
+ * A reader thread splits the file into frames, a pool of decoder threads
+ * decompresses and converts them concurrently, and work() releases the
+ * samples strictly in file order. Only a few frames per decoder are kept in
+ * flight, so memory use doesn't depend on the size of the file.
+ */
+class file_zstd_source_c : public gr_sync_block
+{
+private:
+  friend file_zstd_source_c_sptr make_file_zstd_source_c( const std::string &filename,
+                                                          bool repeat,
+                                                          osmosdr_format_t format,
+                                                          size_t nthreads );
+
+  file_zstd_source_c( const std::string &filename, bool repeat,
+                      osmosdr_format_t format, size_t nthreads );
+
+public:
+  ~file_zstd_source_c();
+
+  int work( int noutput_items,
+            gr_vector_const_void_star &input_items,
+            gr_vector_void_star &output_items );
+
+  /* release samples in real time at the given rate, 0 disables pacing */
+  void set_pacing( double rate );
+
+private:
+  struct frame_t {
+    std::vector< unsigned char > data;  /* compressed */
+    std::vector< gr_complex > samples;  /* decoded */
+    bool ready;
+    std::string error;
+  };
+
+  typedef boost::shared_ptr< frame_t > frame_sptr;
+
+  void reader();
+  void decoder();
+  bool read_frame( std::vector< unsigned char > &frame );
+
+  FILE *_fp;
+  std::string _filename;
+  bool _repeat;
+  osmosdr_format_t _format;
+
+  /* compressed bytes read ahead of the current frame, reader thread only */
+  std::vector< unsigned char > _in;
+  size_t _in_pos, _in_len;
+  bool _in_eof;
+
+  std::deque< frame_sptr > _frames;    /* in file order, decoded or not */
+  std::deque< frame_sptr > _pending;   /* waiting for a decoder */
+  size_t _max_frames;
+  size_t _offset;                      /* samples consumed from the front frame */
+  bool _eof;
+  bool _running;
+
+  boost::mutex _mutex;
+  boost::condition_variable _frame_ready;
+  boost::condition_variable _frame_pending;
+  boost::condition_variable _frame_done;
+  boost::thread_group _threads;
+
+  file_pacer _pacer;
+  boost::mutex _pacer_mutex;
+};
+
+#endif /* INCLUDED_FILE_ZSTD_SOURCE_C_H */
@@ -0,0 +1,184 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2013 Dimitri Stolnikov <horiz0n@gmx.net>
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <algorithm>
+#include <stdexcept>
+
+#include <boost/foreach.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#include "sigmf_meta.h"
+
+using boost::property_tree::ptree;
+
+static const std::string data_ext = ".sigmf-data";
+static const std::string meta_ext = ".sigmf-meta";
+
+std::string sigmf_meta_filename( const std::string &data_filename )
+{
+  size_t len = data_filename.length();
+
+  if ( len > data_ext.length() &&
+       data_filename.compare( len - data_ext.length(), data_ext.length(),
+                              data_ext ) == 0 )
+    return data_filename.substr( 0, len - data_ext.length() ) + meta_ext;
+
+  return data_filename + meta_ext;
+}
+
+std::string sigmf_data_filename( const std::string &meta_filename )
+{
+  size_t len = meta_filename.length();
+
+  if ( len > meta_ext.length() &&
+       meta_filename.compare( len - meta_ext.length(), meta_ext.length(),
+                              meta_ext ) == 0 )
+    return meta_filename.substr( 0, len - meta_ext.length() ) + data_ext;
+
+  return "";
+}
+
+static osmosdr_format_t datatype_to_format( const std::string &datatype )
+{
+  if ( "cu8" == datatype || "cu8_le" == datatype )
+    return OSMOSDR_FORMAT_CU8;
+  else if ( "ci8" == datatype || "ci8_le" == datatype )
+    return OSMOSDR_FORMAT_CS8;
+  else if ( "ci16_le" == datatype )
+    return OSMOSDR_FORMAT_CS16;
+  else if ( "cf32_le" == datatype )
+    return OSMOSDR_FORMAT_CF32;
+
+  throw std::runtime_error( "Unsupported SigMF datatype '" + datatype + "'." );
+}
+
+/* days since 1970-01-01 of a proleptic gregorian date */
+static int64_t days_from_civil( int y, unsigned m, unsigned d )
+{
+  y -= m <= 2;
+  const int64_t era = (y >= 0 ? y : y - 399) / 400;
+  const unsigned yoe = (unsigned)(y - era * 400);
+  const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+  return era * 146097 + (int64_t)doe - 719468;
+}
+
+/* ISO 8601 UTC timestamp as used by SigMF: 2013-05-01T12:00:00.123456Z */
+static void parse_datetime( const std::string &datetime,
+                            uint64_t &full_secs, double &frac_secs )
+{
+  int year, month, day, hour, min;
+  double sec;
+
+  if ( sscanf( datetime.c_str(), "%d-%d-%dT%d:%d:%lf",
+               &year, &month, &day, &hour, &min, &sec ) != 6 ||
+       month < 1 || month > 12 || day < 1 || day > 31 || sec < 0 )
+    throw std::runtime_error( "Malformed SigMF datetime '" + datetime + "'." );
+
+  int64_t secs = days_from_civil( year, month, day ) * 86400 +
+                 hour * 3600 + min * 60 + (int64_t)sec;
+
+  if ( secs < 0 )
+    throw std::runtime_error( "SigMF datetime '" + datetime + "' predates the epoch." );
+
+  full_secs = secs;
+  frac_secs = sec - (int64_t)sec;
+}
+
+static bool by_capture_start( const sigmf_capture_t &a, const sigmf_capture_t &b )
+{
+  return a.sample_start < b.sample_start;
+}
+
+static bool by_annotation_start( const sigmf_annotation_t &a,
+                                 const sigmf_annotation_t &b )
+{
+  return a.sample_start < b.sample_start;
+}
+
+sigmf_meta_t sigmf_read_meta( const std::string &meta_filename )
+{
+  ptree root;
+
+  try {
+    boost::property_tree::read_json( meta_filename, root );
+  } catch ( const boost::property_tree::json_parser_error &ex ) {
+    throw std::runtime_error( "Failed to parse '" + meta_filename + "': " +
+                              ex.what() );
+  }
+
+  sigmf_meta_t meta;
+
+  const ptree &global = root.get_child( "global", ptree() );
+
+  std::string datatype = global.get< std::string >( "core:datatype", "" );
+  if ( datatype.empty() )
+    throw std::runtime_error( "'" + meta_filename + "' lacks core:datatype." );
+
+  meta.format = datatype_to_format( datatype );
+  meta.sample_rate = global.get< double >( "core:sample_rate", 0 );
+
+  BOOST_FOREACH( const ptree::value_type &v,
+                 root.get_child( "captures", ptree() ) )
+  {
+    sigmf_capture_t capture;
+
+    capture.sample_start = v.second.get< uint64_t >( "core:sample_start", 0 );
+    capture.frequency = v.second.get< double >( "core:frequency", 0 );
+    capture.has_time = false;
+    capture.full_secs = 0;
+    capture.frac_secs = 0;
+
+    std::string datetime = v.second.get< std::string >( "core:datetime", "" );
+    if ( ! datetime.empty() ) {
+      parse_datetime( datetime, capture.full_secs, capture.frac_secs );
+      capture.has_time = true;
+    }
+
+    meta.captures.push_back( capture );
+  }
+
+  BOOST_FOREACH( const ptree::value_type &v,
+                 root.get_child( "annotations", ptree() ) )
+  {
+    sigmf_annotation_t annotation;
+
+    annotation.sample_start = v.second.get< uint64_t >( "core:sample_start", 0 );
+    annotation.sample_count = v.second.get< uint64_t >( "core:sample_count", 0 );
+    annotation.label = v.second.get< std::string >( "core:label",
+                         v.second.get< std::string >( "core:comment", "" ) );
+
+    meta.annotations.push_back( annotation );
+  }
+
+  std::stable_sort( meta.captures.begin(), meta.captures.end(),
+                    by_capture_start );
+  std::stable_sort( meta.annotations.begin(), meta.annotations.end(),
+                    by_annotation_start );
+
+  return meta;
+}
@@ -0,0 +1,75 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2013 Dimitri Stolnikov <horiz0n@gmx.net>
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef INCLUDED_SIGMF_META_H
+#define INCLUDED_SIGMF_META_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "osmosdr_convert.h"
+
+/* a segment of the recording with constant tuning, see "captures" in SigMF */
+struct sigmf_capture_t
+{
+  uint64_t sample_start;
+  double frequency;
+  bool has_time;
+  uint64_t full_secs;   /* since the unix epoch, UTC */
+  double frac_secs;
+};
+
+struct sigmf_annotation_t
+{
+  uint64_t sample_start;
+  uint64_t sample_count;
+  std::string label;
+};
+
+struct sigmf_meta_t
+{
+  osmosdr_format_t format;
+  double sample_rate;
+  std::vector< sigmf_capture_t > captures;          /* sorted by sample_start */
+  std::vector< sigmf_annotation_t > annotations;    /* sorted by sample_start */
+};
+
+/*!
+ * Returns the name of the metadata sidecar belonging to a recording,
+ * "name.sigmf-data" maps to "name.sigmf-meta", anything else gets the
+ * ".sigmf-meta" extension appended.
+ */
+std::string sigmf_meta_filename( const std::string &data_filename );
+
+/*!
+ * The inverse of the above, only for names ending with ".sigmf-meta".
+ * Returns an empty string for anything else.
+ */
+std::string sigmf_data_filename( const std::string &meta_filename );
+
+/*!
+ * Parses a SigMF style JSON metadata file. Only the fields needed to play
+ * back the recording are interpreted, unknown ones are ignored.
+ * Throws std::runtime_error if the file is malformed or describes a sample
+ * format we don't support.
+ */
+sigmf_meta_t sigmf_read_meta( const std::string &meta_filename );
+
+#endif /* INCLUDED_SIGMF_META_H */
@@ -29,17 +29,21 @@
 
 #include "hackrf_source_c.h"
 #include <gnuradio/gr_io_signature.h>
+#include <gruel/pmt.h>
 
 #include <boost/assign.hpp>
 #include <boost/format.hpp>
 #include <boost/detail/endian.hpp>
 #include <boost/algorithm/string.hpp>
+#include <boost/bind.hpp>
 #include <boost/thread/thread.hpp>
 
 #include <stdexcept>
+#include <algorithm>
 #include <iostream>
 
 #include <osmosdr_arg_helpers.h>
+#include <osmosdr_recorder.h>
 
 using namespace boost::assign;
 
@@ -85,7 +89,11 @@ hackrf_source_c::hackrf_source_c (const std::string &args)
     _auto_gain(false),
     _amp_gain(0),
     _lna_gain(0),
-    _vga_gain(0)
+    _vga_gain(0),
+    _settle(0),
+    _discard(0),
+    _tag_hops(false),
+    _sweep( boost::bind( &hackrf_source_c::sweep_tune, this, _1, _2 ) )
 {
   int ret;
 
@@ -107,17 +115,28 @@ hackrf_source_c::hackrf_source_c (const std::string &args)
 
   _samp_avail = _buf_len / BYTES_PER_SAMPLE;
 
-  // create a lookup table for gr_complex values
-  for (unsigned int i = 0; i <= 0xffff; i++) {
-#ifdef BOOST_LITTLE_ENDIAN
-    _lut.push_back( gr_complex( (float(i & 0xff) - 127.5f) * (1.0f/128.0f),
-                                (float(i >> 8) - 127.5f) * (1.0f/128.0f) ) );
-#else // BOOST_BIG_ENDIAN
-    _lut.push_back( gr_complex( (float(i >> 8) - 127.5f) * (1.0f/128.0f),
-                                (float(i & 0xff) - 127.5f) * (1.0f/128.0f) ) );
-#endif
+  if (dict.count("settle"))
+    _settle = boost::lexical_cast< double >( dict["settle"] );
+
+  if (dict.count("ddc")) {
+    double offset = 0;
+    if (dict.count("ddc_offset"))
+      offset = boost::lexical_cast< double >( dict["ddc_offset"] );
+
+    _ddc.configure( boost::lexical_cast< size_t >( dict["ddc"] ), offset );
   }
 
+  _marks.resize( _buf_num );
+
+  // create a lookup table for gr_complex values
+  _corr.build_cu8_lut( _lut );
+  _corr.changed();
+
+  /* takes the estimates of a iqbalance_optimize_c directly */
+  message_port_register_in( pmt::pmt_intern( "iqbal_corr" ) );
+  set_msg_handler( pmt::pmt_intern( "iqbal_corr" ),
+                   boost::bind( &osmosdr_correction::iqbal_corr, &_corr, _1 ) );
+
   {
     boost::mutex::scoped_lock lock( _usage_mutex );
 
@@ -172,6 +191,8 @@ hackrf_source_c::hackrf_source_c (const std::string &args)
       _buf[i] = (unsigned short *) malloc(_buf_len);
   }
 
+  _recorder = make_recorder_from_args( dict, "cu8" );
+
 //  _thread = gruel::thread(_hackrf_wait, this);
 
   ret = hackrf_start_rx( _dev, _hackrf_rx_callback, (void *)this );
@@ -185,6 +206,10 @@ hackrf_source_c::hackrf_source_c (const std::string &args)
  */
 hackrf_source_c::~hackrf_source_c ()
 {
+  /* the sweep tunes through the setters, which must be done with the device */
+  _sweep.stop();
+  _setters.stop();
+
   if (_dev) {
 //    _thread.join();
     int ret = hackrf_stop_rx( _dev );
@@ -223,6 +248,12 @@ int hackrf_source_c::_hackrf_rx_callback(hackrf_transfer *transfer)
 
 int hackrf_source_c::hackrf_rx_callback(unsigned char *buf, uint32_t len)
 {
+  if (!_sweep.filled( len / BYTES_PER_SAMPLE ))
+    return 0; /* captured while retuning */
+
+  if (_recorder)
+    _recorder->write(buf, len);
+
   {
     boost::mutex::scoped_lock lock( _buf_mutex );
 
@@ -231,10 +262,14 @@ int hackrf_source_c::hackrf_rx_callback(unsigned char *buf, uint32_t len)
 
     if (_buf_used == _buf_num) {
       std::cerr << "O" << std::flush;
+      _marks.drop( _buf_head, (_buf_head + 1) % _buf_num );
       _buf_head = (_buf_head + 1) % _buf_num;
     } else {
       _buf_used++;
     }
+
+    /* everything queued before was captured with the old settings */
+    _marks.mark( buf_tail );
   }
 
   _buf_cond.notify_one();
@@ -300,37 +335,86 @@ int hackrf_source_c::work( int noutput_items,
   if ( ! running )
     return WORK_DONE;
 
-  unsigned short *buf = _buf[_buf_head] + _buf_offset;
-
-  if (noutput_items <= _samp_avail) {
-    for (int i = 0; i < noutput_items; ++i)
-      *out++ = _lut[ *(buf + i) ];
+  /* new correction values are folded into the table, nothing to do per sample */
+  if ( _corr.changed() )
+    _corr.build_cu8_lut( _lut );
 
-    _buf_offset += noutput_items;
-    _samp_avail -= noutput_items;
-  } else {
-    for (int i = 0; i < _samp_avail; ++i)
-      *out++ = _lut[ *(buf + i) ];
+  int produced = 0;
 
-    {
+  while (produced < noutput_items) {
+    if (0 == _samp_avail) {
       boost::mutex::scoped_lock lock( _buf_mutex );
 
       _buf_head = (_buf_head + 1) % _buf_num;
       _buf_used--;
+
+      _buf_offset = 0;
+      _samp_avail = _buf_len / BYTES_PER_SAMPLE;
+
+      if (0 == _buf_used)
+        break;
     }
 
-    buf = _buf[_buf_head];
+    if (0 == _buf_offset)
+      _corr.estimate_cu8( (unsigned char *)(_buf[_buf_head]), _samp_avail );
 
-    int remaining = noutput_items - _samp_avail;
+    osmosdr_change_marks::changes_t changes;
+    if (0 == _buf_offset && _marks.take( _buf_head, changes )) {
+      for (osmosdr_change_marks::changes_t::iterator it = changes.begin();
+           it != changes.end(); ++it)
+        _changes[ it->first ] = it->second;
 
-    for (int i = 0; i < remaining; ++i)
-      *out++ = _lut[ *(buf + i) ];
+      double settle = _sweep.settle();
+      if (settle < 0)
+        settle = _settle;
+
+      _discard = size_t(settle * _sample_rate); /* device samples */
+    }
+
+    if (_discard) {
+      int n = std::min( _discard, size_t(_samp_avail) );
+
+      _buf_offset += n;
+      _samp_avail -= n;
+      _discard -= n;
+      continue;
+    }
 
-    _buf_offset = remaining;
-    _samp_avail = (_buf_len / BYTES_PER_SAMPLE) - remaining;
+    if (!_changes.empty()) {
+      for (osmosdr_change_marks::changes_t::iterator it = _changes.begin();
+           it != _changes.end(); ++it)
+        add_item_tag( 0, nitems_written(0) + produced,
+                      pmt::pmt_string_to_symbol( it->first ),
+                      pmt::pmt_from_double( it->second ) );
+      _changes.clear();
+    }
+
+    unsigned short *buf = _buf[_buf_head] + _buf_offset;
+    int n, m;
+
+    if ( _ddc.enabled() ) {
+      /* decim device samples per output, the ddc keeps what is left over */
+      n = std::min( (noutput_items - produced) * int(_ddc.decim()), _samp_avail );
+      gr_complex *in = _ddc.input( n );
+
+      for (int i = 0; i < n; ++i)
+        in[i] = _lut[ *(buf + i) ];
+
+      m = _ddc.process( out, noutput_items - produced );
+    } else {
+      n = m = std::min( noutput_items - produced, _samp_avail );
+
+      for (int i = 0; i < n; ++i)
+        out[i] = _lut[ *(buf + i) ];
+    }
+
+    out += m;
+    _buf_offset += n;
+    _samp_avail -= n;
+    produced += m;
   }
 
-  return noutput_items;
+  return produced;
 }
 
 std::vector<std::string> hackrf_source_c::get_devices()
@@ -369,18 +453,25 @@ osmosdr::meta_range_t hackrf_source_c::get_sample_rates()
   range += osmosdr::range_t( 16e6 );
   range += osmosdr::range_t( 20e6 ); /* confirmed to work on fast machines */
 
-  return range;
+  return _ddc.output_rates( range );
 }
 
 double hackrf_source_c::set_sample_rate( double rate )
+{
+  return _setters.call( "rate", boost::bind( &hackrf_source_c::apply_sample_rate, this, rate ) );
+}
+
+double hackrf_source_c::apply_sample_rate( double rate )
 {
   int ret;
 
   if (_dev) {
-    ret = hackrf_sample_rate_set( _dev, uint32_t(rate) );
+    ret = hackrf_sample_rate_set( _dev, uint32_t(_ddc.device_rate( rate )) );
     if ( HACKRF_SUCCESS == ret ) {
-      _sample_rate = rate;
-      set_bandwidth( rate );
+      _sample_rate = _ddc.device_rate( rate );
+      set_bandwidth( _sample_rate );
+      _ddc.set_sample_rate( _sample_rate );
+      _marks.change( "rx_rate", get_sample_rate() );
     } else {
       throw std::runtime_error( std::string( __FUNCTION__ ) + " has failed" );
     }
@@ -391,7 +482,7 @@ double hackrf_source_c::set_sample_rate( double rate )
 
 double hackrf_source_c::get_sample_rate()
 {
-  return _sample_rate;
+  return _ddc.output_rate( _sample_rate );
 }
 
 osmosdr::freq_range_t hackrf_source_c::get_freq_range( size_t chan )
@@ -400,20 +491,26 @@ osmosdr::freq_range_t hackrf_source_c::get_freq_range( size_t chan )
 
   range += osmosdr::range_t( 30e6, 6e9 );
 
-  return range;
+  return _ddc.output_freqs( range );
 }
 
 double hackrf_source_c::set_center_freq( double freq, size_t chan )
+{
+  return _setters.call( "freq", boost::bind( &hackrf_source_c::apply_center_freq, this, freq, chan ) );
+}
+
+double hackrf_source_c::apply_center_freq( double freq, size_t chan )
 {
   int ret;
 
   #define APPLY_PPM_CORR(val, ppm) ((val) * (1.0 + (ppm) * 0.000001))
 
   if (_dev) {
-    double corr_freq = APPLY_PPM_CORR( freq, _freq_corr );
+    double corr_freq = APPLY_PPM_CORR( _ddc.device_freq( freq ), _freq_corr );
     ret = hackrf_set_freq( _dev, uint64_t(corr_freq) );
     if ( HACKRF_SUCCESS == ret ) {
-      _center_freq = freq;
+      _center_freq = _ddc.device_freq( freq );
+      _marks.change( "rx_freq", get_center_freq( chan ) );
     } else {
       throw std::runtime_error( std::string( __FUNCTION__ ) + " has failed" );
     }
@@ -424,14 +521,20 @@ double hackrf_source_c::set_center_freq( double freq, size_t chan )
 
 double hackrf_source_c::get_center_freq( size_t chan )
 {
-  return _center_freq;
+  return _ddc.output_freq( _center_freq );
 }
 
 double hackrf_source_c::set_freq_corr( double ppm, size_t chan )
+{
+  return _setters.call( "corr", boost::bind( &hackrf_source_c::apply_freq_corr, this, ppm, chan ) );
+}
+
+double hackrf_source_c::apply_freq_corr( double ppm, size_t chan )
 {
   _freq_corr = ppm;
 
-  set_center_freq( _center_freq );
+  /* retunes with the new correction and marks the frequency */
+  apply_center_freq( get_center_freq( chan ), chan );
 
   return get_freq_corr( chan );
 }
@@ -487,6 +590,11 @@ bool hackrf_source_c::get_gain_mode( size_t chan )
 }
 
 double hackrf_source_c::set_gain( double gain, size_t chan )
+{
+  return _setters.call( "gain", boost::bind( &hackrf_source_c::apply_gain, this, gain, chan ) );
+}
+
+double hackrf_source_c::apply_gain( double gain, size_t chan )
 {
   osmosdr::gain_range_t rf_gains = get_gain_range( "RF", chan );
 
@@ -494,8 +602,10 @@ double hackrf_source_c::set_gain( double gain, size_t chan )
     double clip_gain = rf_gains.clip( gain, true );
     uint8_t value = clip_gain == 14.0f ? 1 : 0;
 
-    if ( hackrf_set_amp_enable( _dev, value ) == HACKRF_SUCCESS )
+    if ( hackrf_set_amp_enable( _dev, value ) == HACKRF_SUCCESS ) {
       _amp_gain = clip_gain;
+      _marks.change( "rx_gain", _amp_gain );
+    }
   }
 
   return _amp_gain;
@@ -540,7 +650,12 @@ double hackrf_source_c::get_gain( const std::string & name, size_t chan )
   return get_gain( chan );
 }
 
-double hackrf_source_c::set_if_gain(double gain, size_t chan)
+double hackrf_source_c::set_if_gain( double gain, size_t chan )
+{
+  return _setters.call( "if_gain", boost::bind( &hackrf_source_c::apply_if_gain, this, gain, chan ) );
+}
+
+double hackrf_source_c::apply_if_gain( double gain, size_t chan )
 {
   osmosdr::gain_range_t rf_gains = get_gain_range( "IF", chan );
 
@@ -555,6 +670,11 @@ double hackrf_source_c::set_if_gain(double gain, size_t chan)
 }
 
 double hackrf_source_c::set_bb_gain( double gain, size_t chan )
+{
+  return _setters.call( "bb_gain", boost::bind( &hackrf_source_c::apply_bb_gain, this, gain, chan ) );
+}
+
+double hackrf_source_c::apply_bb_gain( double gain, size_t chan )
 {
   osmosdr::gain_range_t if_gains = get_gain_range( "BB", chan );
 
@@ -587,7 +707,56 @@ std::string hackrf_source_c::get_antenna( size_t chan )
   return "TX/RX";
 }
 
+bool hackrf_source_c::fused_iq_balance()
+{
+  return true;
+}
+
+void hackrf_source_c::set_iq_balance( const std::complex<double> &correction, size_t chan )
+{
+  _corr.set_iq_balance( correction );
+}
+
+std::complex<double> hackrf_source_c::get_iq_balance( size_t chan )
+{
+  return _corr.iq_balance();
+}
+
+void hackrf_source_c::set_dc_offset_mode( int mode, size_t chan )
+{
+  _corr.set_dc_offset_mode( mode );
+}
+
+void hackrf_source_c::set_dc_offset( const std::complex<double> &offset, size_t chan )
+{
+  _corr.set_dc_offset( offset );
+}
+
+bool hackrf_source_c::set_sweep( const std::vector< double > &freqs,
+                                 double dwell, double settle,
+                                 bool tag_hops, size_t chan )
+{
+  _tag_hops = tag_hops;
+
+  _sweep.start( freqs, size_t((settle + dwell) * _sample_rate), settle );
+
+  return true;
+}
+
+void hackrf_source_c::sweep_tune( size_t index, double freq )
+{
+  set_center_freq( freq );
+
+  if (_tag_hops)
+    _marks.change( "sweep_hop", index );
+}
+
 double hackrf_source_c::set_bandwidth( double bandwidth, size_t chan )
+{
+  return _setters.call( "bandwidth", boost::bind( &hackrf_source_c::apply_bandwidth, this, bandwidth, chan ) );
+}
+
+double hackrf_source_c::apply_bandwidth( double bandwidth, size_t chan )
 {
   int ret;
 //  osmosdr::freq_range_t bandwidths = get_bandwidth_range( chan );
@@ -639,3 +808,13 @@ osmosdr::freq_range_t hackrf_source_c::get_bandwidth_range( size_t chan )
 
   return bandwidths;
 }
+
+osmosdr_future_t hackrf_source_c::post_center_freq( double freq, size_t chan )
+{
+  return _setters.post( "freq", boost::bind( &hackrf_source_c::apply_center_freq, this, freq, chan ) );
+}
+
+osmosdr_future_t hackrf_source_c::post_gain( double gain, size_t chan )
+{
+  return _setters.post( "gain", boost::bind( &hackrf_source_c::apply_gain, this, gain, chan ) );
+}
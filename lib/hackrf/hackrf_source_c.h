@@ -31,6 +31,12 @@
 #include <libhackrf/hackrf.h>
 
 #include "osmosdr_src_iface.h"
+#include "osmosdr_setter_queue.h"
+#include "osmosdr_change_marks.h"
+#include "osmosdr_sweep.h"
+#include "osmosdr_correction.h"
+#include "osmosdr_ddc.h"
+#include "osmosdr_recorder.h"
 
 class hackrf_source_c;
 
@@ -120,7 +126,29 @@ public:
   double get_bandwidth( size_t chan = 0 );
   osmosdr::freq_range_t get_bandwidth_range( size_t chan = 0 );
 
+  bool set_sweep( const std::vector< double > &freqs,
+                  double dwell, double settle,
+                  bool tag_hops = true, size_t chan = 0 );
+
+  osmosdr_future_t post_center_freq( double freq, size_t chan = 0 );
+  osmosdr_future_t post_gain( double gain, size_t chan = 0 );
+
+  bool fused_iq_balance( void );
+  void set_iq_balance( const std::complex<double> &correction, size_t chan = 0 );
+  std::complex<double> get_iq_balance( size_t chan = 0 );
+
+  void set_dc_offset_mode( int mode, size_t chan = 0 );
+  void set_dc_offset( const std::complex<double> &offset, size_t chan = 0 );
+
 private:
+  double apply_sample_rate( double rate );
+  double apply_center_freq( double freq, size_t chan );
+  double apply_freq_corr( double ppm, size_t chan );
+  double apply_gain( double gain, size_t chan );
+  double apply_if_gain( double gain, size_t chan );
+  double apply_bb_gain( double gain, size_t chan );
+  double apply_bandwidth( double bandwidth, size_t chan );
+
   static int _hackrf_rx_callback(hackrf_transfer* transfer);
   int hackrf_rx_callback(unsigned char *buf, uint32_t len);
   static void _hackrf_wait(hackrf_source_c *obj);
@@ -130,6 +158,8 @@ private:
   static boost::mutex _usage_mutex;
 
   std::vector<gr_complex> _lut;
+  osmosdr_correction _corr; /* baked into _lut by work() */
+  osmosdr_ddc _ddc;         /* between _lut and the output, if enabled */
 
   hackrf_device *_dev;
   gruel::thread _thread;
@@ -152,6 +182,19 @@ private:
   double _lna_gain;
   double _vga_gain;
   double _bandwidth;
+
+  osmosdr_recorder_sptr _recorder;
+
+  osmosdr_change_marks _marks;
+  osmosdr_change_marks::changes_t _changes; /* to be tagged after settling */
+  double _settle;                           /* seconds dropped after a change */
+  size_t _discard;                          /* samples left to drop */
+
+  osmosdr_setter_queue _setters; /* before _sweep, which tunes through it */
+
+  void sweep_tune( size_t index, double freq );
+  bool _tag_hops;
+  osmosdr_sweep _sweep;
 };
 
 #endif /* INCLUDED_HACKRF_SOURCE_C_H */
@@ -41,6 +41,7 @@
 #include <mirisdr.h>
 
 #include <osmosdr_arg_helpers.h>
+#include <osmosdr_recorder.h>
 
 using namespace boost::assign;
 
@@ -140,6 +141,8 @@ miri_source_c::miri_source_c (const std::string &args)
       _buf[i] = (unsigned short *) malloc(BUF_SIZE);
   }
 
+  _recorder = make_recorder_from_args( dict, "cs16" );
+
   _thread = gruel::thread(_mirisdr_wait, this);
 }
 
@@ -182,6 +185,9 @@ void miri_source_c::mirisdr_callback(unsigned char *buf, uint32_t len)
     return;
   }
 
+  if (_recorder)
+    _recorder->write(buf, len);
+
   {
     boost::mutex::scoped_lock lock( _buf_mutex );
 
@@ -27,6 +27,7 @@
 #include <boost/thread/condition_variable.hpp>
 
 #include "osmosdr_src_iface.h"
+#include "osmosdr_recorder.h"
 
 class miri_source_c;
 typedef struct mirisdr_dev mirisdr_dev_t;
@@ -129,6 +130,8 @@ private:
 
   bool _auto_gain;
   unsigned int _skipped;
+
+  osmosdr_recorder_sptr _recorder;
 };
 
 #endif /* INCLUDED_MIRI_SOURCE_C_H */
@@ -40,6 +40,7 @@
 #include <osmosdr.h>
 
 #include <osmosdr_arg_helpers.h>
+#include <osmosdr_recorder.h>
 
 using namespace boost::assign;
 
@@ -139,6 +140,8 @@ osmosdr_src_c::osmosdr_src_c (const std::string &args)
       _buf[i] = (unsigned short *) malloc(_buf_len);
   }
 
+  _recorder = make_recorder_from_args( dict, "cs16" );
+
   _thread = gruel::thread(_osmosdr_wait, this);
 }
 
@@ -179,6 +182,9 @@ void osmosdr_src_c::osmosdr_callback(unsigned char *buf, uint32_t len)
     return;
   }
 
+  if (_recorder)
+    _recorder->write(buf, len);
+
   {
     boost::mutex::scoped_lock lock( _buf_mutex );
 
@@ -27,6 +27,7 @@
 #include <boost/thread/condition_variable.hpp>
 
 #include "osmosdr_src_iface.h"
+#include "osmosdr_recorder.h"
 
 class osmosdr_src_c;
 typedef struct osmosdr_dev osmosdr_dev_t;
@@ -134,6 +135,8 @@ private:
   bool _auto_gain;
   double _if_gain;
   unsigned int _skipped;
+
+  osmosdr_recorder_sptr _recorder;
 };
 
 #endif /* INCLUDED_OSMOSDR_SRC_C_H */
@@ -106,7 +106,12 @@ struct is_nchan_argument
   }
 };
 
-inline gr_io_signature_sptr args_to_io_signature( const std::string &args )
+/*
+ * channelized counts the pfb_chans=M outputs the source makes of every
+ * channel of a device, the devices themselves pass false.
+ */
+inline gr_io_signature_sptr args_to_io_signature( const std::string &args,
+                                                  bool channelized = false )
 {
   size_t max_nchan = 0;
   size_t dev_nchan = 0;
@@ -132,13 +137,18 @@ inline gr_io_signature_sptr args_to_io_signature( const std::string &args )
   BOOST_FOREACH( std::string arg, arg_list )
   {
     dict_t dict = params_to_dict(arg);
+
+    size_t outputs = 1;
+    if (channelized && dict.count("pfb_chans"))
+      outputs = std::max<size_t>( boost::lexical_cast<size_t>( dict["pfb_chans"] ), 1 );
+
     if (dict.count("nchan"))
     {
-      dev_nchan += boost::lexical_cast<size_t>( dict["nchan"] );
+      dev_nchan += boost::lexical_cast<size_t>( dict["nchan"] ) * outputs;
     }
     else // no channels given via args
     {
-      dev_nchan++; // assume one channel
+      dev_nchan += outputs; // assume one channel
     }
   }
 
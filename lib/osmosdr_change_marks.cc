@@ -0,0 +1,91 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2013 Dimitri Stolnikov <horiz0n@gmx.net>
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "osmosdr_change_marks.h"
+
+osmosdr_change_marks::osmosdr_change_marks()
+{
+}
+
+void osmosdr_change_marks::resize( size_t slots )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  _slots.clear();
+  _slots.resize( slots );
+}
+
+void osmosdr_change_marks::change( const std::string &key, double value )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  _pending[ key ] = value;
+}
+
+void osmosdr_change_marks::mark( size_t slot )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  if ( slot >= _slots.size() )
+    return;
+
+  /* an unread slot being refilled loses its samples, not its marks */
+  changes_t &marks = _slots[ slot ];
+
+  for ( changes_t::iterator it = _pending.begin(); it != _pending.end(); ++it )
+    marks[ it->first ] = it->second;
+
+  _pending.clear();
+}
+
+void osmosdr_change_marks::drop( size_t slot, size_t next )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  if ( slot >= _slots.size() || next >= _slots.size() || slot == next )
+    return;
+
+  changes_t &from = _slots[ slot ];
+  changes_t &to = _slots[ next ];
+
+  /* what was marked on the next slot is newer */
+  for ( changes_t::iterator it = from.begin(); it != from.end(); ++it )
+    if ( ! to.count( it->first ) )
+      to[ it->first ] = it->second;
+
+  from.clear();
+}
+
+bool osmosdr_change_marks::take( size_t slot, changes_t &changes )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  if ( slot >= _slots.size() || _slots[ slot ].empty() )
+    return false;
+
+  changes.swap( _slots[ slot ] );
+  _slots[ slot ].clear();
+
+  return true;
+}
@@ -0,0 +1,70 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2013 Dimitri Stolnikov <horiz0n@gmx.net>
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_CHANGE_MARKS_H
+#define OSMOSDR_CHANGE_MARKS_H
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include <boost/thread/mutex.hpp>
+
+/*!
+ * Tracks where in the sample ring of a hardware source a setting change
+ * takes effect.
+ *
+ * The setters report every change they made. The device callback marks the
+ * ring slot it fills next, as everything queued before that slot was
+ * captured with the old settings. work() takes the marks off the slot when
+ * it starts reading it and tags the first sample it outputs from there.
+ *
+ * The transfer which is in flight while the device retunes is a mix of old
+ * and new, which is why the source may drop a configurable settling period
+ * after every change.
+ */
+class osmosdr_change_marks
+{
+public:
+  typedef std::map< std::string, double > changes_t;
+
+  osmosdr_change_marks();
+
+  /* number of slots in the ring, before the device is started */
+  void resize( size_t slots );
+
+  /* setter thread: the value of key changed, e.g. "rx_freq" */
+  void change( const std::string &key, double value );
+
+  /* device thread: the next changes apply from this slot on */
+  void mark( size_t slot );
+
+  /* device thread: the slot is dropped, its marks move on to the next one */
+  void drop( size_t slot, size_t next );
+
+  /* work thread: returns true and the changes if the slot was marked */
+  bool take( size_t slot, changes_t &changes );
+
+private:
+  boost::mutex _mutex;
+  changes_t _pending;
+  std::vector< changes_t > _slots;
+};
+
+#endif // OSMOSDR_CHANGE_MARKS_H
@@ -0,0 +1,92 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2013 Dimitri Stolnikov <horiz0n@gmx.net>
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdexcept>
+
+#include <gr_io_signature.h>
+#include <boost/bind.hpp>
+
+#include "osmosdr_control.h"
+
+osmosdr_control_sptr make_osmosdr_control( osmosdr_control::apply_fn_t apply )
+{
+  return gnuradio::get_initial_sptr( new osmosdr_control( apply ) );
+}
+
+osmosdr_control::osmosdr_control( apply_fn_t apply )
+  : gr_block( "osmosdr_control",
+              gr_make_io_signature( 0, 0, 0 ),
+              gr_make_io_signature( 0, 0, 0 ) ),
+    _apply(apply)
+{
+  message_port_register_in( pmt::pmt_intern( "command" ) );
+  set_msg_handler( pmt::pmt_intern( "command" ),
+                   boost::bind( &osmosdr_control::handle_command, this, _1 ) );
+  message_port_register_out( pmt::pmt_intern( "status" ) );
+}
+
+void osmosdr_control::handle_command( pmt::pmt_t cmd )
+{
+  pmt::pmt_t status;
+
+  try {
+    status = _apply( cmd );
+  } catch ( std::exception &ex ) {
+    status = pmt::pmt_dict_add( pmt::pmt_make_dict(),
+                                pmt::pmt_intern( "error" ),
+                                pmt::pmt_intern( ex.what() ) );
+  }
+
+  message_port_pub( pmt::pmt_intern( "status" ), status );
+}
+
+bool command_get( const pmt::pmt_t &cmd, const std::string &key, double &value )
+{
+  pmt::pmt_t v = pmt::pmt_dict_ref( cmd, pmt::pmt_intern( key ), pmt::PMT_NIL );
+
+  if ( pmt::pmt_eq( v, pmt::PMT_NIL ) )
+    return false;
+
+  if ( ! pmt::pmt_is_number( v ) )
+    throw std::runtime_error( "The value of " + key + " must be a number." );
+
+  value = pmt::pmt_to_double( v );
+
+  return true;
+}
+
+bool command_get( const pmt::pmt_t &cmd, const std::string &key, std::string &value )
+{
+  pmt::pmt_t v = pmt::pmt_dict_ref( cmd, pmt::pmt_intern( key ), pmt::PMT_NIL );
+
+  if ( pmt::pmt_eq( v, pmt::PMT_NIL ) )
+    return false;
+
+  if ( ! pmt::pmt_is_symbol( v ) )
+    throw std::runtime_error( "The value of " + key + " must be a string." );
+
+  value = pmt::pmt_symbol_to_string( v );
+
+  return true;
+}
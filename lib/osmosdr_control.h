@@ -0,0 +1,69 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2013 Dimitri Stolnikov <horiz0n@gmx.net>
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_CONTROL_H
+#define OSMOSDR_CONTROL_H
+
+#include <string>
+
+#include <gr_block.h>
+#include <boost/function.hpp>
+
+class osmosdr_control;
+typedef boost::shared_ptr< osmosdr_control > osmosdr_control_sptr;
+
+/*!
+ * Applies the commands arriving on its "command" message port and publishes
+ * the outcome on its "status" port.
+ *
+ * A hierarchical block has no thread of its own to dispatch messages, so the
+ * source and sink blocks keep one of these as a stand-alone block in their
+ * graph and hand it out through control_block(). The scheduler runs the
+ * handler on the thread of this block, so a slow tuner never holds up the
+ * sender.
+ *
+ * A command is a PMT dict, for example ((freq . 100e6) (gain . 20) (chan . 0)).
+ * Recognized keys are chan, rate, freq, gain, bandwidth and antenna. The
+ * status is a dict of the actual values, with an error entry if the command
+ * failed.
+ */
+class osmosdr_control : public gr_block
+{
+public:
+  typedef boost::function< pmt::pmt_t ( pmt::pmt_t ) > apply_fn_t;
+
+private:
+  friend osmosdr_control_sptr make_osmosdr_control( apply_fn_t apply );
+
+  osmosdr_control( apply_fn_t apply );
+
+  void handle_command( pmt::pmt_t cmd );
+
+  apply_fn_t _apply;
+};
+
+osmosdr_control_sptr make_osmosdr_control( osmosdr_control::apply_fn_t apply );
+
+/* look up a number in a command dict, returns false if absent */
+bool command_get( const pmt::pmt_t &cmd, const std::string &key, double &value );
+
+/* look up a symbol in a command dict, returns false if absent */
+bool command_get( const pmt::pmt_t &cmd, const std::string &key, std::string &value );
+
+#endif // OSMOSDR_CONTROL_H
@@ -0,0 +1,368 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2013 Dimitri Stolnikov <horiz0n@gmx.net>
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef OSMOSDR_CONVERT_H
+#define OSMOSDR_CONVERT_H
+
+#include <string>
+#include <stdexcept>
+#include <string.h>
+#include <stdint.h>
+
+#include <boost/detail/endian.hpp>
+
+#include <gr_complex.h>
+
+#if defined(USE_SSE2) || defined(USE_AVX)
+#include <emmintrin.h>
+#define OSMOSDR_CONVERT_SSE2
+#endif
+
+/*
+ * Raw IQ sample formats as they are delivered by the hardware or stored in
+ * capture files. All integer formats are interleaved I/Q, little endian.
+ */
+enum osmosdr_format_t {
+  OSMOSDR_FORMAT_CU8 = 0,   /* 8 bit unsigned, as delivered by rtl & hackrf */
+  OSMOSDR_FORMAT_CS8,       /* 8 bit signed */
+  OSMOSDR_FORMAT_CS16,      /* 16 bit signed */
+  OSMOSDR_FORMAT_CF32       /* 32 bit float, same as gr_complex */
+};
+
+inline osmosdr_format_t string_to_format( const std::string &format )
+{
+  if ( "cu8" == format )
+    return OSMOSDR_FORMAT_CU8;
+  else if ( "cs8" == format )
+    return OSMOSDR_FORMAT_CS8;
+  else if ( "cs16" == format )
+    return OSMOSDR_FORMAT_CS16;
+  else if ( "cf32" == format )
+    return OSMOSDR_FORMAT_CF32;
+
+  throw std::runtime_error( "Unsupported sample format '" + format + "'." );
+}
+
+inline std::string format_to_string( osmosdr_format_t format )
+{
+  switch ( format ) {
+  case OSMOSDR_FORMAT_CU8:  return "cu8";
+  case OSMOSDR_FORMAT_CS8:  return "cs8";
+  case OSMOSDR_FORMAT_CS16: return "cs16";
+  case OSMOSDR_FORMAT_CF32: return "cf32";
+  }
+
+  return "";
+}
+
+/* size of a single complex sample in bytes */
+inline size_t format_sample_size( osmosdr_format_t format )
+{
+  switch ( format ) {
+  case OSMOSDR_FORMAT_CU8:  return 2 * sizeof(uint8_t);
+  case OSMOSDR_FORMAT_CS8:  return 2 * sizeof(int8_t);
+  case OSMOSDR_FORMAT_CS16: return 2 * sizeof(int16_t);
+  case OSMOSDR_FORMAT_CF32: return sizeof(gr_complex);
+  }
+
+  return 0;
+}
+
+/* same mapping as the lookup tables of the rtl and hackrf sources */
+inline void convert_cu8_to_cf32( const uint8_t *in, gr_complex *out, size_t count )
+{
+  const float scale = 1.0f/128.0f;
+  float *outf = (float *)out;
+  size_t i = 0;
+
+#ifdef OSMOSDR_CONVERT_SSE2
+  const __m128 mul = _mm_set1_ps( scale );
+  const __m128 sub = _mm_set1_ps( 127.5f );
+  const __m128i zero = _mm_setzero_si128();
+
+  /* 8 complex samples (16 bytes) per iteration */
+  for (; i + 8 <= count; i += 8) {
+    __m128i bytes = _mm_loadu_si128( (const __m128i *)(in + i*2) );
+
+    /* zero extend 8 -> 16 -> 32 bits */
+    __m128i lo16 = _mm_unpacklo_epi8( bytes, zero );
+    __m128i hi16 = _mm_unpackhi_epi8( bytes, zero );
+
+    __m128i a = _mm_unpacklo_epi16( lo16, zero );
+    __m128i b = _mm_unpackhi_epi16( lo16, zero );
+    __m128i c = _mm_unpacklo_epi16( hi16, zero );
+    __m128i d = _mm_unpackhi_epi16( hi16, zero );
+
+    _mm_storeu_ps( outf + i*2 + 0,
+                   _mm_mul_ps( _mm_sub_ps( _mm_cvtepi32_ps( a ), sub ), mul ) );
+    _mm_storeu_ps( outf + i*2 + 4,
+                   _mm_mul_ps( _mm_sub_ps( _mm_cvtepi32_ps( b ), sub ), mul ) );
+    _mm_storeu_ps( outf + i*2 + 8,
+                   _mm_mul_ps( _mm_sub_ps( _mm_cvtepi32_ps( c ), sub ), mul ) );
+    _mm_storeu_ps( outf + i*2 + 12,
+                   _mm_mul_ps( _mm_sub_ps( _mm_cvtepi32_ps( d ), sub ), mul ) );
+  }
+#endif
+
+  for (; i < count; i++) {
+    outf[i*2 + 0] = (in[i*2 + 0] - 127.5f) * scale;
+    outf[i*2 + 1] = (in[i*2 + 1] - 127.5f) * scale;
+  }
+}
+
+/* sums of the I and of the Q bytes of count 8 bit unsigned samples */
+inline void sum_cu8( const uint8_t *in, size_t count, uint64_t &sum_i, uint64_t &sum_q )
+{
+  size_t i = 0;
+  sum_i = sum_q = 0;
+
+#ifdef OSMOSDR_CONVERT_SSE2
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i even = _mm_set1_epi16( 0x00ff );
+  __m128i acc_i = zero, acc_q = zero;
+
+  /* 8 complex samples (16 bytes) per iteration, psadbw against zero adds
+   * up 8 bytes at a time into the two 64 bit halves */
+  for (; i + 8 <= count; i += 8) {
+    __m128i bytes = _mm_loadu_si128( (const __m128i *)(in + i*2) );
+
+    acc_i = _mm_add_epi64( acc_i, _mm_sad_epu8( _mm_and_si128( bytes, even ), zero ) );
+    acc_q = _mm_add_epi64( acc_q, _mm_sad_epu8( _mm_srli_epi16( bytes, 8 ), zero ) );
+  }
+
+  uint64_t lanes[2];
+  _mm_storeu_si128( (__m128i *)lanes, acc_i );
+  sum_i = lanes[0] + lanes[1];
+  _mm_storeu_si128( (__m128i *)lanes, acc_q );
+  sum_q = lanes[0] + lanes[1];
+#endif
+
+  for (; i < count; i++) {
+    sum_i += in[i*2 + 0];
+    sum_q += in[i*2 + 1];
+  }
+}
+
+inline void convert_cs8_to_cf32( const int8_t *in, gr_complex *out, size_t count )
+{
+  const float scale = 1.0f/128.0f;
+  float *outf = (float *)out;
+  size_t i = 0;
+
+#ifdef OSMOSDR_CONVERT_SSE2
+  const __m128 mul = _mm_set1_ps( scale );
+
+  /* 8 complex samples (16 bytes) per iteration */
+  for (; i + 8 <= count; i += 8) {
+    __m128i bytes = _mm_loadu_si128( (const __m128i *)(in + i*2) );
+
+    /* sign extend 8 -> 16 bits */
+    __m128i lo16 = _mm_srai_epi16( _mm_unpacklo_epi8( bytes, bytes ), 8 );
+    __m128i hi16 = _mm_srai_epi16( _mm_unpackhi_epi8( bytes, bytes ), 8 );
+
+    /* sign extend 16 -> 32 bits */
+    __m128i a = _mm_srai_epi32( _mm_unpacklo_epi16( lo16, lo16 ), 16 );
+    __m128i b = _mm_srai_epi32( _mm_unpackhi_epi16( lo16, lo16 ), 16 );
+    __m128i c = _mm_srai_epi32( _mm_unpacklo_epi16( hi16, hi16 ), 16 );
+    __m128i d = _mm_srai_epi32( _mm_unpackhi_epi16( hi16, hi16 ), 16 );
+
+    _mm_storeu_ps( outf + i*2 + 0,  _mm_mul_ps( _mm_cvtepi32_ps( a ), mul ) );
+    _mm_storeu_ps( outf + i*2 + 4,  _mm_mul_ps( _mm_cvtepi32_ps( b ), mul ) );
+    _mm_storeu_ps( outf + i*2 + 8,  _mm_mul_ps( _mm_cvtepi32_ps( c ), mul ) );
+    _mm_storeu_ps( outf + i*2 + 12, _mm_mul_ps( _mm_cvtepi32_ps( d ), mul ) );
+  }
+#endif
+
+  for (; i < count; i++) {
+    outf[i*2 + 0] = in[i*2 + 0] * scale;
+    outf[i*2 + 1] = in[i*2 + 1] * scale;
+  }
+}
+
+inline int16_t le16_to_host( int16_t value )
+{
+#ifdef BOOST_LITTLE_ENDIAN
+  return value;
+#else
+  uint16_t v = (uint16_t)value;
+  return (int16_t)((v >> 8) | (v << 8));
+#endif
+}
+
+inline void convert_cs16_to_cf32( const int16_t *in, gr_complex *out, size_t count )
+{
+  const float scale = 1.0f/32768.0f;
+  float *outf = (float *)out;
+  size_t i = 0;
+
+#if defined(OSMOSDR_CONVERT_SSE2) && defined(BOOST_LITTLE_ENDIAN)
+  const __m128 mul = _mm_set1_ps( scale );
+
+  /* 4 complex samples (16 bytes) per iteration */
+  for (; i + 4 <= count; i += 4) {
+    __m128i shorts = _mm_loadu_si128( (const __m128i *)(in + i*2) );
+
+    __m128i a = _mm_srai_epi32( _mm_unpacklo_epi16( shorts, shorts ), 16 );
+    __m128i b = _mm_srai_epi32( _mm_unpackhi_epi16( shorts, shorts ), 16 );
+
+    _mm_storeu_ps( outf + i*2 + 0, _mm_mul_ps( _mm_cvtepi32_ps( a ), mul ) );
+    _mm_storeu_ps( outf + i*2 + 4, _mm_mul_ps( _mm_cvtepi32_ps( b ), mul ) );
+  }
+#endif
+
+  for (; i < count; i++) {
+    outf[i*2 + 0] = le16_to_host( in[i*2 + 0] ) * scale;
+    outf[i*2 + 1] = le16_to_host( in[i*2 + 1] ) * scale;
+  }
+}
+
+/*!
+ * Convert count raw samples of the given format to gr_complex.
+ * The input buffer does not need to be aligned.
+ */
+inline void convert_to_cf32( osmosdr_format_t format,
+                             const void *in, gr_complex *out, size_t count )
+{
+  switch ( format ) {
+  case OSMOSDR_FORMAT_CU8:
+    convert_cu8_to_cf32( (const uint8_t *)in, out, count );
+    break;
+  case OSMOSDR_FORMAT_CS8:
+    convert_cs8_to_cf32( (const int8_t *)in, out, count );
+    break;
+  case OSMOSDR_FORMAT_CS16:
+    convert_cs16_to_cf32( (const int16_t *)in, out, count );
+    break;
+  case OSMOSDR_FORMAT_CF32:
+    memcpy( out, in, count * sizeof(gr_complex) );
+    break;
+  }
+}
+
+/*
+ * The reverse direction, used when writing raw samples. Values are rounded
+ * and saturated to the range of the target format.
+ */
+inline int16_t host_to_le16( int16_t value )
+{
+  return le16_to_host( value );
+}
+
+template< typename T >
+inline T clip_round( float value, float lo, float hi )
+{
+  value = value < lo ? lo : (value > hi ? hi : value);
+  return T( value < 0 ? value - 0.5f : value + 0.5f );
+}
+
+inline void convert_cf32_to_cu8( const gr_complex *in, uint8_t *out, size_t count )
+{
+  const float *inf = (const float *)in;
+  size_t i = 0;
+
+#ifdef OSMOSDR_CONVERT_SSE2
+  const __m128 mul = _mm_set1_ps( 128.0f );
+  const __m128 add = _mm_set1_ps( 127.5f );
+
+  /* 8 complex samples (16 bytes) per iteration */
+  for (; i + 8 <= count; i += 8) {
+    __m128i a = _mm_cvtps_epi32( _mm_add_ps( _mm_mul_ps( _mm_loadu_ps( inf + i*2 + 0 ), mul ), add ) );
+    __m128i b = _mm_cvtps_epi32( _mm_add_ps( _mm_mul_ps( _mm_loadu_ps( inf + i*2 + 4 ), mul ), add ) );
+    __m128i c = _mm_cvtps_epi32( _mm_add_ps( _mm_mul_ps( _mm_loadu_ps( inf + i*2 + 8 ), mul ), add ) );
+    __m128i d = _mm_cvtps_epi32( _mm_add_ps( _mm_mul_ps( _mm_loadu_ps( inf + i*2 + 12 ), mul ), add ) );
+
+    /* saturating packs 32 -> 16 -> 8 bits */
+    __m128i bytes = _mm_packus_epi16( _mm_packs_epi32( a, b ), _mm_packs_epi32( c, d ) );
+    _mm_storeu_si128( (__m128i *)(out + i*2), bytes );
+  }
+#endif
+
+  for (i *= 2; i < count * 2; i++) /* the rest, counted in values */
+    out[i] = clip_round< uint8_t >( inf[i] * 128.0f + 127.5f, 0.0f, 255.0f );
+}
+
+inline void convert_cf32_to_cs8( const gr_complex *in, int8_t *out, size_t count )
+{
+  const float *inf = (const float *)in;
+  size_t i = 0;
+
+#ifdef OSMOSDR_CONVERT_SSE2
+  const __m128 mul = _mm_set1_ps( 128.0f );
+
+  for (; i + 8 <= count; i += 8) {
+    __m128i a = _mm_cvtps_epi32( _mm_mul_ps( _mm_loadu_ps( inf + i*2 + 0 ), mul ) );
+    __m128i b = _mm_cvtps_epi32( _mm_mul_ps( _mm_loadu_ps( inf + i*2 + 4 ), mul ) );
+    __m128i c = _mm_cvtps_epi32( _mm_mul_ps( _mm_loadu_ps( inf + i*2 + 8 ), mul ) );
+    __m128i d = _mm_cvtps_epi32( _mm_mul_ps( _mm_loadu_ps( inf + i*2 + 12 ), mul ) );
+
+    __m128i bytes = _mm_packs_epi16( _mm_packs_epi32( a, b ), _mm_packs_epi32( c, d ) );
+    _mm_storeu_si128( (__m128i *)(out + i*2), bytes );
+  }
+#endif
+
+  for (i *= 2; i < count * 2; i++)
+    out[i] = clip_round< int8_t >( inf[i] * 128.0f, -128.0f, 127.0f );
+}
+
+inline void convert_cf32_to_cs16( const gr_complex *in, int16_t *out, size_t count )
+{
+  const float *inf = (const float *)in;
+  size_t i = 0;
+
+#if defined(OSMOSDR_CONVERT_SSE2) && defined(BOOST_LITTLE_ENDIAN)
+  const __m128 mul = _mm_set1_ps( 32768.0f );
+
+  /* 4 complex samples (16 bytes) per iteration */
+  for (; i + 4 <= count; i += 4) {
+    __m128i a = _mm_cvtps_epi32( _mm_mul_ps( _mm_loadu_ps( inf + i*2 + 0 ), mul ) );
+    __m128i b = _mm_cvtps_epi32( _mm_mul_ps( _mm_loadu_ps( inf + i*2 + 4 ), mul ) );
+
+    _mm_storeu_si128( (__m128i *)(out + i*2), _mm_packs_epi32( a, b ) );
+  }
+#endif
+
+  for (i *= 2; i < count * 2; i++)
+    out[i] = host_to_le16( clip_round< int16_t >( inf[i] * 32768.0f, -32768.0f, 32767.0f ) );
+}
+
+/*!
+ * Convert count gr_complex samples to the given raw format.
+ * The output buffer does not need to be aligned.
+ */
+inline void convert_from_cf32( osmosdr_format_t format,
+                               const gr_complex *in, void *out, size_t count )
+{
+  switch ( format ) {
+  case OSMOSDR_FORMAT_CU8:
+    convert_cf32_to_cu8( in, (uint8_t *)out, count );
+    break;
+  case OSMOSDR_FORMAT_CS8:
+    convert_cf32_to_cs8( in, (int8_t *)out, count );
+    break;
+  case OSMOSDR_FORMAT_CS16:
+    convert_cf32_to_cs16( in, (int16_t *)out, count );
+    break;
+  case OSMOSDR_FORMAT_CF32:
+    memcpy( out, in, count * sizeof(gr_complex) );
+    break;
+  }
+}
+
+#endif // OSMOSDR_CONVERT_H
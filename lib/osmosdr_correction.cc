@@ -0,0 +1,203 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2013 Dimitri Stolnikov <horiz0n@gmx.net>
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <math.h>
+
+#include <boost/detail/endian.hpp>
+
+#include "osmosdr_correction.h"
+#include "osmosdr_convert.h"
+
+/* estimate the DC offset from one buffer out of this many */
+#define DC_ESTIMATE_DECIM 4
+
+/* weight of a new estimate in the running mean */
+#define DC_ESTIMATE_ALPHA 0.25
+
+/* rebuild the table once the running mean moved by a quarter LSB */
+#define DC_ESTIMATE_THRESHOLD (0.25 / 128.0)
+
+osmosdr_correction::osmosdr_correction()
+  : _dc_mode( osmosdr_source_c::DCOffsetOff ),
+    _dc_offset( 0 ),
+    _dc_estimate( 0 ),
+    _dc_buffers( 0 ),
+    _iq_balance( 0 ),
+    _changed( true )
+{
+}
+
+void osmosdr_correction::set_dc_offset_mode( int mode )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  /* switching to Manual keeps the last estimate */
+  if ( mode != _dc_mode ) {
+    _dc_mode = mode;
+    _dc_buffers = 0;
+    _changed = true;
+  }
+}
+
+int osmosdr_correction::dc_offset_mode()
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  return _dc_mode;
+}
+
+void osmosdr_correction::set_dc_offset( const std::complex<double> &offset )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  if ( osmosdr_source_c::DCOffsetAutomatic == _dc_mode )
+    return;
+
+  if ( offset != _dc_offset ) {
+    _dc_offset = offset;
+    _changed = true;
+  }
+}
+
+std::complex<double> osmosdr_correction::dc_offset()
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  return _dc_offset;
+}
+
+void osmosdr_correction::estimate_cu8( const unsigned char *buf, size_t count )
+{
+  {
+    boost::mutex::scoped_lock lock( _mutex );
+
+    if ( osmosdr_source_c::DCOffsetAutomatic != _dc_mode || ! count )
+      return;
+
+    if ( _dc_buffers++ % DC_ESTIMATE_DECIM )
+      return;
+  }
+
+  uint64_t sum_i, sum_q;
+  sum_cu8( buf, count, sum_i, sum_q );
+
+  /* in the units of the lookup table, before any correction */
+  std::complex<double> mean( (double(sum_i) / count - 127.5) / 128.0,
+                             (double(sum_q) / count - 127.5) / 128.0 );
+
+  boost::mutex::scoped_lock lock( _mutex );
+
+  if ( osmosdr_source_c::DCOffsetAutomatic != _dc_mode )
+    return;
+
+  if ( 1 == _dc_buffers ) /* first estimate since switching on */
+    _dc_estimate = mean;
+  else
+    _dc_estimate += DC_ESTIMATE_ALPHA * (mean - _dc_estimate);
+
+  if ( 1 == _dc_buffers ||
+       fabs( _dc_estimate.real() - _dc_offset.real() ) > DC_ESTIMATE_THRESHOLD ||
+       fabs( _dc_estimate.imag() - _dc_offset.imag() ) > DC_ESTIMATE_THRESHOLD ) {
+    _dc_offset = _dc_estimate;
+    _changed = true;
+  }
+}
+
+void osmosdr_correction::set_iq_balance( const std::complex<double> &correction )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  if ( correction != _iq_balance ) {
+    _iq_balance = correction;
+    _changed = true;
+  }
+}
+
+std::complex<double> osmosdr_correction::iq_balance()
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  return _iq_balance;
+}
+
+void osmosdr_correction::iqbal_corr( pmt::pmt_t msg )
+{
+  /* the optimizer publishes mag and phase as a f32vector */
+  if ( ! pmt::pmt_is_f32vector( msg ) || pmt::pmt_length( msg ) < 2 )
+    return;
+
+  std::complex<double> residual( pmt::pmt_f32vector_ref( msg, 0 ),
+                                 pmt::pmt_f32vector_ref( msg, 1 ) );
+
+  boost::mutex::scoped_lock lock( _mutex );
+
+  /* it sees samples corrected by us already, what it finds is what is left */
+  if ( residual != std::complex<double>( 0 ) ) {
+    _iq_balance += residual;
+    _changed = true;
+  }
+}
+
+bool osmosdr_correction::changed()
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  bool changed = _changed;
+  _changed = false;
+
+  return changed;
+}
+
+void osmosdr_correction::build_cu8_lut( std::vector< gr_complex > &lut )
+{
+  std::complex<double> dc, iq;
+
+  {
+    boost::mutex::scoped_lock lock( _mutex );
+    if ( osmosdr_source_c::DCOffsetOff != _dc_mode )
+      dc = _dc_offset;
+    iq = _iq_balance;
+  }
+
+  /* same as iqbalance_fix_cc */
+  const float magp1 = 1.0f + float(iq.real());
+  const float sinp = sinf( float(iq.imag()) );
+  const float cosp = cosf( float(iq.imag()) );
+
+  lut.resize( 0x10000 );
+
+  for (unsigned int i = 0; i <= 0xffff; i++) {
+#ifdef BOOST_LITTLE_ENDIAN
+    float re = (float(i & 0xff) - 127.5f) * (1.0f/128.0f);
+    float im = (float(i >> 8) - 127.5f) * (1.0f/128.0f);
+#else // BOOST_BIG_ENDIAN
+    float re = (float(i >> 8) - 127.5f) * (1.0f/128.0f);
+    float im = (float(i & 0xff) - 127.5f) * (1.0f/128.0f);
+#endif
+    re = (re - float(dc.real())) * magp1;
+    im = (im - float(dc.imag()) + sinp * re) / cosp;
+
+    lut[i] = gr_complex( re, im );
+  }
+}
@@ -0,0 +1,87 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2013 Dimitri Stolnikov <horiz0n@gmx.net>
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_CORRECTION_H
+#define OSMOSDR_CORRECTION_H
+
+#include <vector>
+#include <complex>
+
+#include <osmosdr/osmosdr_source_c.h>
+#include <gr_complex.h>
+#include <gruel/pmt.h>
+#include <boost/thread/mutex.hpp>
+
+/*!
+ * DC offset and IQ balance correction applied by a source while it converts
+ * the raw samples, instead of in separate blocks behind it.
+ *
+ * The setters may be called from any thread. The work() thread asks
+ * changed() once per call and rebuilds its conversion table when it says so.
+ * Both corrections are affine in I and Q, so for the 8 bit devices they fold
+ * into the lookup table and cost nothing per sample.
+ *
+ * In automatic DC offset mode the work() thread hands every new buffer to
+ * estimate_cu8(), which looks at one in DC_ESTIMATE_DECIM of them and keeps
+ * a running mean of the offset. The correction only follows the mean once
+ * it moved by more than DC_ESTIMATE_THRESHOLD, so the table isn't rebuilt
+ * for noise.
+ */
+class osmosdr_correction
+{
+public:
+  osmosdr_correction();
+
+  /* mode as in osmosdr_source_c::DCOffsetMode, starts Off */
+  void set_dc_offset_mode( int mode );
+  int dc_offset_mode();
+
+  /* ignored in automatic mode, as it would be overwritten right away */
+  void set_dc_offset( const std::complex<double> &offset );
+  std::complex<double> dc_offset();
+
+  /* feeds a buffer of 8 bit unsigned samples into the running mean */
+  void estimate_cu8( const unsigned char *buf, size_t count );
+
+  /* mag and phase as used by gr-iqbal, 0 for no correction */
+  void set_iq_balance( const std::complex<double> &correction );
+  std::complex<double> iq_balance();
+
+  /* message handler for the "iqbal_corr" port of an iqbalance_optimize_c
+   * fed with the corrected samples, adds its estimate to the correction */
+  void iqbal_corr( pmt::pmt_t msg );
+
+  /* true once after every change */
+  bool changed();
+
+  /* table of the corrected values of all 8 bit unsigned I/Q pairs,
+   * indexed with the pair as read from the buffer into a short */
+  void build_cu8_lut( std::vector< gr_complex > &lut );
+
+private:
+  boost::mutex _mutex;
+  int _dc_mode;
+  std::complex<double> _dc_offset;
+  std::complex<double> _dc_estimate;
+  size_t _dc_buffers;
+  std::complex<double> _iq_balance;
+  bool _changed;
+};
+
+#endif // OSMOSDR_CORRECTION_H
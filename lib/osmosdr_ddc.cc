@@ -0,0 +1,167 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2013 Dimitri Stolnikov <horiz0n@gmx.net>
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+#include <gr_firdes.h>
+#include <gr_fir_ccc.h>
+#include <gr_fir_util.h>
+#include <gr_expj.h>
+
+#include "osmosdr_ddc.h"
+
+/* the pass band covers this much of the output rate, the rest is transition */
+#define DDC_PASSBAND 0.8
+
+osmosdr_ddc::osmosdr_ddc()
+  : _decim( 1 ),
+    _offset( 0 ),
+    _rate( 0 ),
+    _redesign( false ),
+    _fir( NULL ),
+    _fill( 0 )
+{
+}
+
+osmosdr_ddc::~osmosdr_ddc()
+{
+  delete _fir;
+}
+
+void osmosdr_ddc::configure( size_t decim, double offset )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  _decim = decim < 1 ? 1 : decim;
+  _offset = offset;
+  _redesign = true;
+}
+
+void osmosdr_ddc::set_sample_rate( double rate )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  if ( rate != _rate ) {
+    _rate = rate;
+    _redesign = true;
+  }
+}
+
+osmosdr::meta_range_t osmosdr_ddc::output_rates( const osmosdr::meta_range_t &device_rates ) const
+{
+  osmosdr::meta_range_t rates;
+
+  for (size_t i = 0; i < device_rates.size(); i++)
+    rates.push_back( osmosdr::range_t( output_rate( device_rates[i].start() ),
+                                       output_rate( device_rates[i].stop() ),
+                                       output_rate( device_rates[i].step() ) ) );
+
+  return rates;
+}
+
+osmosdr::freq_range_t osmosdr_ddc::output_freqs( const osmosdr::freq_range_t &device_freqs ) const
+{
+  osmosdr::freq_range_t freqs;
+
+  for (size_t i = 0; i < device_freqs.size(); i++)
+    freqs.push_back( osmosdr::range_t( output_freq( device_freqs[i].start() ),
+                                       output_freq( device_freqs[i].stop() ),
+                                       device_freqs[i].step() ) );
+
+  return freqs;
+}
+
+gr_complex *osmosdr_ddc::input( size_t count )
+{
+  if ( _buf.size() < _fill + count )
+    _buf.resize( _fill + count );
+
+  gr_complex *in = &_buf[_fill];
+  _fill += count;
+
+  return in;
+}
+
+size_t osmosdr_ddc::process( gr_complex *out, size_t max_out )
+{
+  {
+    boost::mutex::scoped_lock lock( _mutex );
+
+    if ( _redesign && _rate > 0 ) {
+      design( _rate );
+      _redesign = false;
+    }
+  }
+
+  if ( ! _fir )
+    return 0;
+
+  size_t ntaps = _fir->ntaps();
+  if ( _fill < ntaps )
+    return 0;
+
+  size_t n = std::min( (_fill - ntaps) / _decim + 1, max_out );
+
+  _fir->filterNdec( out, &_buf[0], n, _decim );
+
+  for (size_t i = 0; i < n; i++)
+    out[i] = _rotator.rotate( out[i] );
+
+  /* keep the history for the next output */
+  size_t used = n * _decim;
+  memmove( &_buf[0], &_buf[used], (_fill - used) * sizeof(gr_complex) );
+  _fill -= used;
+
+  return n;
+}
+
+void osmosdr_ddc::design( double rate )
+{
+  double out_rate = rate / _decim;
+
+  std::vector< float > proto = \
+      gr_firdes::low_pass( 1.0, rate,
+                           out_rate * DDC_PASSBAND / 2,
+                           out_rate * (1.0 - DDC_PASSBAND),
+                           gr_firdes::WIN_HAMMING );
+
+  /* a band pass around the offset, as gr_freq_xlating_fir_filter_ccc does */
+  float fwT0 = 2 * M_PI * _offset / rate;
+
+  std::vector< gr_complex > taps( proto.size() );
+  for (size_t i = 0; i < proto.size(); i++)
+    taps[i] = proto[i] * gr_expj( i * fwT0 );
+
+  if ( _fir )
+    _fir->set_taps( taps );
+  else
+    _fir = gr_fir_util::create_gr_fir_ccc( taps );
+
+  _rotator.set_phase_incr( gr_expj( -fwT0 * _decim ) );
+
+  /* the samples in flight were taken at the previous rate */
+  _fill = 0;
+}
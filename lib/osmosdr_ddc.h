@@ -0,0 +1,91 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2013 Dimitri Stolnikov <horiz0n@gmx.net>
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_DDC_H
+#define OSMOSDR_DDC_H
+
+#include <vector>
+
+#include <osmosdr/osmosdr_ranges.h>
+#include <gr_complex.h>
+#include <gr_rotator.h>
+#include <boost/thread/mutex.hpp>
+
+class gr_fir_ccc;
+
+/*!
+ * Digital downconverter run by a source on the samples it converts, before
+ * they reach the scheduler.
+ *
+ * The channel at offset Hz from the tuned frequency is shifted to DC, low
+ * pass filtered and decimated, the same way gr_freq_xlating_fir_filter_ccc
+ * does it: the taps are rotated to a band pass around the offset, only every
+ * decim'th output is computed by the SIMD gr_fir_ccc and the NCO runs at the
+ * output rate.
+ *
+ * A source keeps its hardware settings and converts between them and what
+ * its users see with the output_ / device_ helpers, which leave the values
+ * alone while the stage is disabled.
+ */
+class osmosdr_ddc
+{
+public:
+  osmosdr_ddc();
+  ~osmosdr_ddc();
+
+  /* decim 1 at offset 0 disables the stage */
+  void configure( size_t decim, double offset );
+  bool enabled() const { return _decim > 1 || _offset != 0; }
+  size_t decim() const { return _decim; }
+
+  /* the device rate, the filter is designed for it on the next process() */
+  void set_sample_rate( double rate );
+
+  double output_rate( double device_rate ) const { return device_rate / _decim; }
+  double device_rate( double output_rate ) const { return output_rate * _decim; }
+  double output_freq( double device_freq ) const { return device_freq + _offset; }
+  double device_freq( double output_freq ) const { return output_freq - _offset; }
+
+  osmosdr::meta_range_t output_rates( const osmosdr::meta_range_t &device_rates ) const;
+  osmosdr::freq_range_t output_freqs( const osmosdr::freq_range_t &device_freqs ) const;
+
+  /* room for count more device samples, to be filled before process() */
+  gr_complex *input( size_t count );
+
+  /* filters what has been input, returns the number of samples written to out */
+  size_t process( gr_complex *out, size_t max_out );
+
+private:
+  void design( double rate );
+
+  size_t _decim;
+  double _offset;
+
+  boost::mutex _mutex;
+  double _rate;
+  bool _redesign;
+
+  gr_fir_ccc *_fir;
+  gr_rotator _rotator;
+
+  std::vector< gr_complex > _buf; /* history and samples not filtered yet */
+  size_t _fill;
+};
+
+#endif // OSMOSDR_DDC_H
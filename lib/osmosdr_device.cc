@@ -22,9 +22,10 @@
 #include <stdexcept>
 #include <boost/foreach.hpp>
 #include <boost/format.hpp>
-#include <boost/thread/mutex.hpp>
+#include <boost/bind.hpp>
 #include <algorithm>
 #include <sstream>
+#include <iostream>
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
@@ -50,6 +51,10 @@
 #include <rtl_tcp_source_c.h>
 #endif
 
+#ifdef ENABLE_UDP
+#include <udp_source_c.h>
+#endif
+
 #ifdef ENABLE_UHD
 #include <uhd_source_c.h>
 #endif
@@ -68,6 +73,8 @@
 
 
 #include "osmosdr_arg_helpers.h"
+#include "osmosdr_device_cache.h"
+#include "osmosdr_parallel.h"
 
 using namespace osmosdr;
 
@@ -75,8 +82,6 @@ static const std::string args_delim = " ";
 static const std::string pairs_delim = ",";
 static const std::string pair_delim = "=";
 
-static boost::mutex _device_mutex;
-
 device_t::device_t(const std::string &args)
 {
   dict_t dict = params_to_dict(args);
@@ -112,39 +117,40 @@ std::string device_t::to_string(void) const
   return ss.str();
 }
 
-devices_t device::find(const device_t &hint)
+struct backend_t
 {
-  boost::mutex::scoped_lock lock(_device_mutex);
+  std::string type;           /* the device argument selecting it */
+  std::string key;            /* identifies it in the device cache */
+  get_devices_fn_t get_devices;
+};
 
-  devices_t devices;
+#define BACKEND(type, cls) \
+  { backend_t backend = { type, #cls, &cls::get_devices }; backends.push_back( backend ); }
+
+static std::vector< backend_t > get_backends()
+{
+  std::vector< backend_t > backends;
 
 #ifdef ENABLE_OSMOSDR
-  BOOST_FOREACH( std::string dev, osmosdr_src_c::get_devices() )
-    devices.push_back( device_t(dev) );
+  BACKEND( "osmosdr", osmosdr_src_c );
 #endif
 #ifdef ENABLE_FCD
-  BOOST_FOREACH( std::string dev, fcd_source::get_devices() )
-    devices.push_back( device_t(dev) );
+  BACKEND( "fcd", fcd_source );
 #endif
 #ifdef ENABLE_RTL
-  BOOST_FOREACH( std::string dev, rtl_source_c::get_devices() )
-    devices.push_back( device_t(dev) );
+  BACKEND( "rtl", rtl_source_c );
 #endif
 #ifdef ENABLE_UHD
-  BOOST_FOREACH( std::string dev, uhd_source_c::get_devices() )
-    devices.push_back( device_t(dev) );
+  BACKEND( "uhd", uhd_source_c );
 #endif
 #ifdef ENABLE_MIRI
-  BOOST_FOREACH( std::string dev, miri_source_c::get_devices() )
-    devices.push_back( device_t(dev) );
+  BACKEND( "miri", miri_source_c );
 #endif
 #ifdef ENABLE_HACKRF
-  BOOST_FOREACH( std::string dev, hackrf_source_c::get_devices() )
-  devices.push_back( device_t(dev) );
+  BACKEND( "hackrf", hackrf_source_c );
 #endif
 #ifdef ENABLE_BLADERF
-  BOOST_FOREACH( std::string dev, bladerf_source_c::get_devices() )
-  devices.push_back( device_t(dev) );
+  BACKEND( "bladerf", bladerf_source_c );
 #endif
 
   /* software-only sources should be appended at the very end,
@@ -152,13 +158,78 @@ devices_t device::find(const device_t &hint)
    * in a graphical interface etc... */
 
 #ifdef ENABLE_RTL_TCP
-  BOOST_FOREACH( std::string dev, rtl_tcp_source_c::get_devices() )
-    devices.push_back( device_t(dev) );
+  BACKEND( "rtl_tcp", rtl_tcp_source_c );
+#endif
+#ifdef ENABLE_UDP
+  BACKEND( "udp", udp_source_c );
 #endif
 #ifdef ENABLE_FILE
-  BOOST_FOREACH( std::string dev, file_source_c::get_devices() )
-    devices.push_back( device_t(dev) );
+  BACKEND( "file", file_source_c );
 #endif
 
+  return backends;
+}
+
+static void probe( const backend_t &backend, std::vector< std::string > &found )
+{
+  found = cached_get_devices( backend.key, backend.get_devices );
+}
+
+/* values given in the hint have to match where the device reports them */
+static bool matches( const device_t &dev, const device_t &hint )
+{
+  BOOST_FOREACH( const device_t::value_type &entry, hint ) {
+    if ( entry.second.empty() )
+      continue;
+
+    device_t::const_iterator it = dev.find( entry.first );
+    if ( it != dev.end() && it->second != entry.second )
+      return false;
+  }
+
+  return true;
+}
+
+devices_t device::find(const device_t &hint)
+{
+  std::vector< backend_t > backends = get_backends();
+
+  /* a hint naming device types restricts the search to those */
+  std::vector< backend_t > selected;
+  BOOST_FOREACH( const backend_t &backend, backends )
+    if ( hint.count( backend.type ) )
+      selected.push_back( backend );
+
+  if ( selected.empty() )
+    selected = backends;
+
+  std::vector< std::vector< std::string > > found( selected.size() );
+  std::vector< parallel_job_t > jobs;
+
+  for ( size_t i = 0; i < selected.size(); i++ )
+    jobs.push_back( boost::bind( &probe, boost::cref( selected[i] ),
+                                 boost::ref( found[i] ) ) );
+
+  std::vector< std::string > errors = run_parallel( jobs );
+
+  devices_t devices;
+
+  for ( size_t i = 0; i < selected.size(); i++ ) {
+    if ( errors[i].length() )
+      std::cerr << "Failed to probe for " << selected[i].type << " devices: "
+                << errors[i] << std::endl;
+
+    BOOST_FOREACH( const std::string &dev, found[i] ) {
+      device_t device( dev );
+      if ( matches( device, hint ) )
+        devices.push_back( device );
+    }
+  }
+
   return devices;
 }
+
+void device::invalidate_cache( void )
+{
+  invalidate_device_cache();
+}
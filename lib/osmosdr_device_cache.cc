@@ -0,0 +1,106 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2013 Dimitri Stolnikov <horiz0n@gmx.net>
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <map>
+
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#include "osmosdr_device_cache.h"
+
+using namespace boost::posix_time;
+
+struct device_cache_entry_t
+{
+  std::vector< std::string > devices;
+  ptime expires;
+  bool probing;
+};
+
+typedef std::map< std::string, device_cache_entry_t > device_cache_t;
+
+static boost::mutex _cache_mutex;
+static boost::condition_variable _cache_cond;
+static device_cache_t _cache;
+
+std::vector< std::string > cached_get_devices( const std::string &key,
+                                               get_devices_fn_t get_devices )
+{
+  boost::mutex::scoped_lock lock( _cache_mutex );
+
+  while ( true ) {
+    device_cache_t::iterator it = _cache.find( key );
+    if ( it == _cache.end() )
+      break;
+
+    /* somebody else is asking the backend right now, take their answer */
+    if ( it->second.probing ) {
+      _cache_cond.wait( lock );
+      continue;
+    }
+
+    if ( microsec_clock::universal_time() < it->second.expires )
+      return it->second.devices;
+
+    break;
+  }
+
+  _cache[ key ].probing = true;
+
+  /* probe without holding the lock, other backends may be asked meanwhile */
+  lock.unlock();
+
+  std::vector< std::string > devices;
+
+  try {
+    devices = get_devices();
+  } catch ( ... ) {
+    lock.lock();
+    _cache.erase( key );
+    _cache_cond.notify_all();
+    throw;
+  }
+
+  lock.lock();
+
+  device_cache_entry_t &entry = _cache[ key ];
+  entry.devices = devices;
+  entry.expires = microsec_clock::universal_time() + seconds( DEVICE_CACHE_TTL );
+  entry.probing = false;
+
+  _cache_cond.notify_all();
+
+  return devices;
+}
+
+void invalidate_device_cache()
+{
+  boost::mutex::scoped_lock lock( _cache_mutex );
+
+  /* keep entries being probed, a backend is never asked twice at once */
+  device_cache_t::iterator it = _cache.begin();
+  while ( it != _cache.end() ) {
+    if ( it->second.probing )
+      ++it;
+    else
+      _cache.erase( it++ );
+  }
+}
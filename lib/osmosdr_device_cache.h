@@ -0,0 +1,46 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2013 Dimitri Stolnikov <horiz0n@gmx.net>
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_DEVICE_CACHE_H
+#define OSMOSDR_DEVICE_CACHE_H
+
+#include <string>
+#include <vector>
+
+typedef std::vector< std::string > (*get_devices_fn_t)( void );
+
+/* seconds a probe result stays valid */
+#define DEVICE_CACHE_TTL 5
+
+/*!
+ * Returns what get_devices() of a backend reported, probing again only
+ * when the last answer is older than DEVICE_CACHE_TTL seconds. Probing
+ * broadcasts on the network or opens USB devices and may take seconds.
+ * Concurrent callers asking for the same backend share a single probe.
+ * The backend is identified by key, e.g. its class name.
+ */
+std::vector< std::string > cached_get_devices( const std::string &key,
+                                               get_devices_fn_t get_devices );
+
+/*!
+ * Forgets all cached results, the next call probes the hardware again.
+ */
+void invalidate_device_cache();
+
+#endif // OSMOSDR_DEVICE_CACHE_H
@@ -0,0 +1,104 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2013 Dimitri Stolnikov <horiz0n@gmx.net>
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+
+#include <boost/bind.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "osmosdr_parallel.h"
+
+struct parallel_state_t
+{
+  const std::vector< parallel_job_t > *jobs;
+  std::vector< std::string > *errors;
+  size_t next;
+  boost::mutex mutex;
+};
+
+static void run_job( const parallel_job_t &job, std::string &error )
+{
+  try {
+    job();
+  } catch ( std::exception &ex ) {
+    error = ex.what();
+    if ( error.empty() )
+      error = "Unknown error.";
+  } catch ( ... ) {
+    error = "Unknown error.";
+  }
+}
+
+static void worker( parallel_state_t *state )
+{
+  while ( true ) {
+    size_t index;
+
+    {
+      boost::mutex::scoped_lock lock( state->mutex );
+
+      if ( state->next >= state->jobs->size() )
+        return;
+
+      index = state->next++;
+    }
+
+    run_job( (*state->jobs)[index], (*state->errors)[index] );
+  }
+}
+
+std::vector< std::string > run_parallel( const std::vector< parallel_job_t > &jobs,
+                                         size_t max_threads )
+{
+  std::vector< std::string > errors( jobs.size() );
+
+  size_t nthreads = std::min( jobs.size(), std::max< size_t >( max_threads, 1 ) );
+
+  if ( nthreads <= 1 ) {
+    for ( size_t i = 0; i < jobs.size(); i++ )
+      run_job( jobs[i], errors[i] );
+
+    return errors;
+  }
+
+  parallel_state_t state;
+  state.jobs = &jobs;
+  state.errors = &errors;
+  state.next = 0;
+
+  boost::thread_group threads;
+
+  for ( size_t i = 0; i < nthreads; i++ )
+    threads.create_thread( boost::bind( &worker, &state ) );
+
+  threads.join_all();
+
+  return errors;
+}
+
+void throw_first_error( const std::vector< std::string > &errors )
+{
+  for ( size_t i = 0; i < errors.size(); i++ )
+    if ( errors[i].length() )
+      throw std::runtime_error( errors[i] );
+}
@@ -0,0 +1,50 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2013 Dimitri Stolnikov <horiz0n@gmx.net>
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_PARALLEL_H
+#define OSMOSDR_PARALLEL_H
+
+#include <string>
+#include <vector>
+
+#include <boost/function.hpp>
+
+typedef boost::function< void ( void ) > parallel_job_t;
+
+/* device I/O mostly waits on USB or the network, not the CPU */
+#define PARALLEL_MAX_THREADS 8
+
+/*!
+ * Runs the jobs on a small pool of threads and waits for all of them to
+ * finish. A single job is run on the calling thread.
+ *
+ * Exceptions don't propagate, instead the message of the exception a job
+ * threw is returned at the position of the job. Jobs that succeeded get an
+ * empty string.
+ */
+std::vector< std::string > run_parallel( const std::vector< parallel_job_t > &jobs,
+                                         size_t max_threads = PARALLEL_MAX_THREADS );
+
+/*!
+ * Throws the first error returned by run_parallel() as std::runtime_error,
+ * if there was any.
+ */
+void throw_first_error( const std::vector< std::string > &errors );
+
+#endif // OSMOSDR_PARALLEL_H
@@ -27,17 +27,8 @@ using namespace osmosdr;
 /***********************************************************************
  * range_t implementation code
  **********************************************************************/
-struct range_t::impl{
-    impl(double start, double stop, double step):
-        start(start), stop(stop), step(step)
-    {
-        /* NOP */
-    }
-    double start, stop, step;
-};
-
 range_t::range_t(double value):
-    _impl(OSMOSDR_PIMPL_MAKE(impl, (value, value, 0)))
+    _start(value), _stop(value), _step(0)
 {
     /* NOP */
 }
@@ -45,7 +36,7 @@ range_t::range_t(double value):
 range_t::range_t(
     double start, double stop, double step
 ):
-    _impl(OSMOSDR_PIMPL_MAKE(impl, (start, stop, step)))
+    _start(start), _stop(stop), _step(step)
 {
     if (stop < start){
         throw std::runtime_error("cannot make range where stop < start");
@@ -53,15 +44,15 @@ range_t::range_t(
 }
 
 double range_t::start(void) const{
-    return _impl->start;
+    return _start;
 }
 
 double range_t::stop(void) const{
-    return _impl->stop;
+    return _stop;
 }
 
 double range_t::step(void) const{
-    return _impl->step;
+    return _step;
 }
 
 const std::string range_t::to_pp_string(void) const{
@@ -76,82 +67,96 @@ const std::string range_t::to_pp_string(void) const{
 /***********************************************************************
  * meta_range_t implementation code
  **********************************************************************/
-void check_meta_range_monotonic(const meta_range_t &mr){
-    if (mr.empty()){
-        throw std::runtime_error("meta-range cannot be empty");
-    }
-    for (size_t i = 1; i < mr.size(); i++){
-        if (mr.at(i).start() < mr.at(i-1).stop()){
-            throw std::runtime_error("meta-range is not monotonic");
-        }
-    }
-}
-
-meta_range_t::meta_range_t(void){
+meta_range_t::meta_range_t(void):
+    _valid_size(0)
+{
     /* NOP */
 }
 
 meta_range_t::meta_range_t(
     double start, double stop, double step
 ):
-    std::vector<range_t > (1, range_t(start, stop, step))
+    std::vector<range_t > (1, range_t(start, stop, step)),
+    _valid_size(0)
 {
-    /* NOP */
+    update();
 }
 
-double meta_range_t::start(void) const{
-    check_meta_range_monotonic(*this);
+void meta_range_t::update(void) const{
+    if (_valid_size == this->size() && ! this->empty()) return;
+
+    if (this->empty()){
+        throw std::runtime_error("meta-range cannot be empty");
+    }
+
     double min_start = this->front().start();
-    BOOST_FOREACH(const range_t &r, (*this)){
+    double max_stop = this->front().stop();
+    double min_step = 0;
+    const range_t *last = &this->front();
+
+    for (size_t i = 0; i < this->size(); i++){
+        const range_t &r = (*this)[i];
+
+        if (i > 0 && r.start() < last->stop()){
+            throw std::runtime_error("meta-range is not monotonic");
+        }
+
         min_start = std::min(min_start, r.start());
+        max_stop = std::max(max_stop, r.stop());
+
+        //steps at each range and in-between ranges, the smallest one wins
+        double ibtw_step = r.start() - last->stop();
+        if (r.step() > 0 && (min_step == 0 || r.step() < min_step)) min_step = r.step();
+        if (ibtw_step > 0 && (min_step == 0 || ibtw_step < min_step)) min_step = ibtw_step;
+
+        last = &r;
     }
-    return min_start;
+
+    _start = min_start;
+    _stop = max_stop;
+    _step = min_step;
+    _valid_size = this->size();
+}
+
+double meta_range_t::start(void) const{
+    update();
+    return _start;
 }
 
 double meta_range_t::stop(void) const{
-    check_meta_range_monotonic(*this);
-    double max_stop = this->front().stop();
-    BOOST_FOREACH(const range_t &r, (*this)){
-        max_stop = std::max(max_stop, r.stop());
-    }
-    return max_stop;
+    update();
+    return _stop;
 }
 
 double meta_range_t::step(void) const{
-    check_meta_range_monotonic(*this);
-    std::vector<double> non_zero_steps;
-    range_t last = this->front();
-    BOOST_FOREACH(const range_t &r, (*this)){
-        //steps at each range
-        if (r.step() > 0) non_zero_steps.push_back(r.step());
-        //and steps in-between ranges
-        double ibtw_step = r.start() - last.stop();
-        if (ibtw_step > 0) non_zero_steps.push_back(ibtw_step);
-        //store ref to last
-        last = r;
-    }
-    if (non_zero_steps.empty()) return 0; //all zero steps, its zero...
-    return *std::min_element(non_zero_steps.begin(), non_zero_steps.end());
+    update();
+    return _step;
+}
+
+static bool stops_before(const range_t &r, double value){
+    return r.stop() < value;
 }
 
 double meta_range_t::clip(double value, bool clip_step) const{
-    check_meta_range_monotonic(*this);
-    double last_stop = this->front().stop();
-    BOOST_FOREACH(const range_t &r, (*this)){
-        //in-between ranges, clip to nearest
-        if (value < r.start()){
-            return (std::abs(value - r.start()) < std::abs(value - last_stop))?
-                r.start() : last_stop;
-        }
-        //in this range, clip here
-        if (value <= r.stop()){
-            if (! clip_step || r.step() == 0) return value;
-            return boost::math::round((value - r.start())/r.step())*r.step() + r.start();
-        }
-        //continue on to the next range
-        last_stop = r.stop();
+    update();
+
+    //the first range which doesn't end below the value
+    const_iterator it = std::lower_bound(this->begin(), this->end(), value, stops_before);
+
+    if (it == this->end()) return this->back().stop();
+
+    const range_t &r = *it;
+
+    //in-between ranges, clip to nearest
+    if (value < r.start()){
+        double last_stop = (it == this->begin())? r.stop() : (it - 1)->stop();
+        return (std::abs(value - r.start()) < std::abs(value - last_stop))?
+            r.start() : last_stop;
     }
-    return last_stop;
+
+    //in this range, clip here
+    if (! clip_step || r.step() == 0) return value;
+    return boost::math::round((value - r.start())/r.step())*r.step() + r.start();
 }
 
 std::vector<double> meta_range_t::values() const {
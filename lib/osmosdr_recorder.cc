@@ -0,0 +1,382 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2013 Dimitri Stolnikov <horiz0n@gmx.net>
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <iostream>
+#include <stdexcept>
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <io.h>
+#include <malloc.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <boost/format.hpp>
+#include <boost/bind.hpp>
+#include <boost/algorithm/string.hpp>
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "osmosdr_recorder.h"
+
+#define CHUNK_SIZE  (1024 * 1024) /* bytes per disk write, multiple of the block size */
+#define CHUNK_NUM   64            /* chunks in flight, 64 MB of slack for slow disks */
+#define CHUNK_ALIGN 4096          /* satisfies O_DIRECT on all common file systems */
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+static unsigned char *alloc_chunk()
+{
+  void *p = NULL;
+#ifdef _WIN32
+  p = _aligned_malloc( CHUNK_SIZE, CHUNK_ALIGN );
+#else
+  if ( posix_memalign( &p, CHUNK_ALIGN, CHUNK_SIZE ) != 0 )
+    p = NULL;
+#endif
+  if ( ! p )
+    throw std::runtime_error( "Failed to allocate recording buffers." );
+
+  return (unsigned char *)p;
+}
+
+static void free_chunk( unsigned char *p )
+{
+#ifdef _WIN32
+  _aligned_free( p );
+#else
+  free( p );
+#endif
+}
+
+osmosdr_recorder::osmosdr_recorder( const std::string &filename,
+                                    const std::string &format,
+                                    uint64_t rotate_bytes,
+                                    int compress_level )
+  : _filename(filename),
+    _rotate_bytes(rotate_bytes),
+    _file_index(0),
+    _fd(-1),
+    _direct(false),
+    _file_bytes(0),
+    _compress_level(compress_level),
+    _cctx(NULL),
+    _cur(NULL),
+    _cur_len(0),
+    _running(true),
+    _written(0),
+    _dropped(0)
+{
+  /* rotate on chunk boundaries, keeps every direct write aligned */
+  if ( _rotate_bytes )
+    _rotate_bytes = std::max< uint64_t >( CHUNK_SIZE,
+                      _rotate_bytes - _rotate_bytes % CHUNK_SIZE );
+
+  try {
+    if ( _compress_level ) {
+#ifdef HAVE_ZSTD
+      _cctx = ZSTD_createCCtx();
+      _zbuf.resize( ZSTD_compressBound( CHUNK_SIZE ) );
+#else
+      throw std::runtime_error( "Compressed recording requires zstd support, "
+                                "which is not built in." );
+#endif
+    }
+
+    for ( unsigned int i = 0; i < CHUNK_NUM; i++ )
+      _free.push_back( alloc_chunk() );
+
+    open_next();
+  } catch ( ... ) {
+    while ( _free.size() ) {
+      free_chunk( _free.front() );
+      _free.pop_front();
+    }
+#ifdef HAVE_ZSTD
+    if ( _cctx )
+      ZSTD_freeCCtx( (ZSTD_CCtx *)_cctx );
+#endif
+    throw;
+  }
+
+  _cur = _free.front();
+  _free.pop_front();
+
+  std::cerr << "Recording raw " << format << " samples to " << _filename;
+  if ( _compress_level )
+    std::cerr << ", zstd level " << _compress_level << " compressed";
+  if ( _rotate_bytes )
+    std::cerr << ", starting a new file every " << _rotate_bytes << " bytes";
+  std::cerr << "." << std::endl;
+
+  _thread = gruel::thread( boost::bind( &osmosdr_recorder::writer, this ) );
+}
+
+osmosdr_recorder::~osmosdr_recorder()
+{
+  {
+    boost::mutex::scoped_lock lock( _mutex );
+    _running = false;
+  }
+  _cond.notify_one();
+  _thread.join();
+
+  /* the writer drained all full chunks, only the partial one is left */
+  if ( _cur ) {
+    close_file( _cur, _cur_len );
+    _written += _cur_len;
+    free_chunk( _cur );
+  } else {
+    close_file( NULL, 0 );
+  }
+
+  while ( _free.size() ) {
+    free_chunk( _free.front() );
+    _free.pop_front();
+  }
+
+#ifdef HAVE_ZSTD
+  if ( _cctx )
+    ZSTD_freeCCtx( (ZSTD_CCtx *)_cctx );
+#endif
+
+  std::cerr << "Recorded " << _written << " bytes";
+  if ( _dropped )
+    std::cerr << ", dropped " << _dropped << " bytes because the disk was too slow";
+  std::cerr << "." << std::endl;
+}
+
+void osmosdr_recorder::open_next()
+{
+  std::string name = _filename;
+
+  if ( _rotate_bytes ) {
+    std::string suffix = str( boost::format("_%04u") % _file_index++ );
+
+    /* keep the sample format visible: capture_0000.cu8.zst */
+    std::string zst;
+    if ( boost::algorithm::ends_with( name, ".zst" ) ) {
+      zst = ".zst";
+      name.erase( name.length() - zst.length() );
+    }
+
+    size_t dot = name.find_last_of( '.' );
+    size_t slash = name.find_last_of( "/\\" );
+    if ( dot != std::string::npos && (slash == std::string::npos || dot > slash) )
+      name.insert( dot, suffix );
+    else
+      name += suffix;
+
+    name += zst;
+  }
+
+  int flags = O_WRONLY | O_CREAT | O_TRUNC | O_BINARY;
+
+  _direct = false;
+#ifdef O_DIRECT
+  /* compressed chunks have arbitrary sizes, those go through the page cache */
+  if ( ! _compress_level ) {
+    _fd = ::open( name.c_str(), flags | O_DIRECT, 0644 );
+    if ( _fd >= 0 )
+      _direct = true;
+  }
+  if ( _fd < 0 ) /* tmpfs and friends refuse direct I/O */
+#endif
+    _fd = ::open( name.c_str(), flags, 0644 );
+
+  if ( _fd < 0 )
+    throw std::runtime_error( "Failed to open '" + name + "' for recording: " +
+                              strerror(errno) );
+
+  _file_bytes = 0;
+}
+
+void osmosdr_recorder::close_file( const unsigned char *tail, size_t tail_len )
+{
+  if ( _fd < 0 )
+    return;
+
+  if ( tail_len ) {
+#ifdef O_DIRECT
+    /* the last piece is unlikely to be a multiple of the block size */
+    if ( _direct )
+      fcntl( _fd, F_SETFL, fcntl( _fd, F_GETFL ) & ~O_DIRECT );
+#endif
+    if ( ! write_chunk( tail, tail_len ) )
+      std::cerr << "Failed to write recording: " << strerror(errno) << std::endl;
+  }
+
+  ::close( _fd );
+  _fd = -1;
+}
+
+bool osmosdr_recorder::write_chunk( const unsigned char *data, size_t len )
+{
+#ifdef HAVE_ZSTD
+  if ( _cctx ) {
+    size_t ret = ZSTD_compressCCtx( (ZSTD_CCtx *)_cctx, &_zbuf[0], _zbuf.size(),
+                                    data, len, _compress_level );
+    if ( ZSTD_isError( ret ) ) {
+      errno = EINVAL;
+      return false;
+    }
+
+    data = &_zbuf[0];
+    len = ret;
+  }
+#endif
+
+  if ( ::write( _fd, data, len ) != (ssize_t)len )
+    return false;
+
+  _file_bytes += len;
+
+  return true;
+}
+
+void osmosdr_recorder::write( const void *data, size_t len )
+{
+  const unsigned char *p = (const unsigned char *)data;
+  bool notify = false;
+
+  {
+    boost::mutex::scoped_lock lock( _mutex );
+
+    while ( len ) {
+      if ( ! _cur ) {
+        if ( _free.empty() ) {
+          _dropped += len;
+          break;
+        }
+
+        _cur = _free.front();
+        _free.pop_front();
+        _cur_len = 0;
+      }
+
+      size_t n = std::min( len, size_t(CHUNK_SIZE) - _cur_len );
+      memcpy( _cur + _cur_len, p, n );
+      _cur_len += n;
+      p += n;
+      len -= n;
+
+      if ( CHUNK_SIZE == _cur_len ) {
+        _full.push_back( _cur );
+        _cur = NULL;
+        notify = true;
+      }
+    }
+  }
+
+  if ( notify )
+    _cond.notify_one();
+}
+
+void osmosdr_recorder::writer()
+{
+  while ( true ) {
+    unsigned char *chunk;
+
+    {
+      boost::mutex::scoped_lock lock( _mutex );
+
+      while ( _full.empty() && _running )
+        _cond.wait( lock );
+
+      if ( _full.empty() )
+        break;
+
+      chunk = _full.front();
+      _full.pop_front();
+    }
+
+    if ( _fd >= 0 && _rotate_bytes && _file_bytes >= _rotate_bytes ) {
+      close_file( NULL, 0 );
+      try {
+        open_next();
+      } catch ( std::exception &ex ) {
+        std::cerr << ex.what() << " Recording stopped." << std::endl;
+      }
+    }
+
+    if ( _fd >= 0 ) {
+      if ( ! write_chunk( chunk, CHUNK_SIZE ) ) {
+        std::cerr << "Failed to write recording: " << strerror(errno)
+                  << ", recording stopped." << std::endl;
+        ::close( _fd );
+        _fd = -1;
+      } else {
+        _written += CHUNK_SIZE;
+      }
+    }
+
+    {
+      boost::mutex::scoped_lock lock( _mutex );
+      _free.push_back( chunk );
+
+      /* the callback ran dry, hand it a fresh chunk right away */
+      if ( ! _cur && _free.size() ) {
+        _cur = _free.front();
+        _free.pop_front();
+        _cur_len = 0;
+      }
+    }
+  }
+}
+
+osmosdr_recorder_sptr make_recorder_from_args( dict_t &dict, const std::string &format )
+{
+  if ( ! dict.count("record") || dict["record"].empty() )
+    return osmosdr_recorder_sptr();
+
+  uint64_t rotate = 0;
+  if ( dict.count("record_rotate") )
+    rotate = (uint64_t)boost::lexical_cast< double >( dict["record_rotate"] );
+
+  bool zst = boost::algorithm::ends_with( dict["record"], ".zst" );
+
+  int level = 0;
+  if ( dict.count("record_compress") )
+    level = boost::lexical_cast< int >( dict["record_compress"] );
+  else if ( zst )
+    level = 1; /* the fastest level keeps up with any of the devices */
+
+  if ( zst && level <= 0 )
+    throw std::runtime_error( "Recording to '" + dict["record"] + "' requires "
+                              "a record_compress level of at least 1." );
+
+  return osmosdr_recorder_sptr( new osmosdr_recorder( dict["record"], format,
+                                                      rotate, level ) );
+}
@@ -0,0 +1,102 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2013 Dimitri Stolnikov <horiz0n@gmx.net>
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_RECORDER_H
+#define OSMOSDR_RECORDER_H
+
+#include <string>
+#include <deque>
+#include <vector>
+#include <stdint.h>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <gruel/thread.h>
+
+#include "osmosdr_arg_helpers.h"
+
+/*!
+ * Writes the raw sample stream of a hardware source to disk.
+ *
+ * write() is meant to be called from the USB callback. It only copies the
+ * transfer into a preallocated chunk and never blocks on the disk. Full
+ * chunks are written by a separate thread, bypassing the page cache
+ * (O_DIRECT) where the file system allows it. If the disk can't keep up the
+ * excess data is dropped and accounted for, the live stream is unaffected.
+ *
+ * With rotation enabled, a new file is started after the given number of
+ * bytes. The files are numbered: capture.cu8 becomes capture_0000.cu8,
+ * capture_0001.cu8 and so on.
+ *
+ * With a compression level given, every chunk is written as an independent
+ * zstd frame, which the file source decodes in parallel.
+ */
+class osmosdr_recorder
+{
+public:
+  osmosdr_recorder( const std::string &filename, const std::string &format,
+                    uint64_t rotate_bytes = 0, int compress_level = 0 );
+  ~osmosdr_recorder();
+
+  void write( const void *data, size_t len );
+
+private:
+  void writer();
+  void open_next();
+  void close_file( const unsigned char *tail, size_t tail_len );
+  bool write_chunk( const unsigned char *data, size_t len );
+
+  std::string _filename;
+  uint64_t _rotate_bytes;
+  unsigned int _file_index;
+  int _fd;
+  bool _direct;
+  uint64_t _file_bytes;
+
+  int _compress_level;
+  void *_cctx;
+  std::vector< unsigned char > _zbuf;
+
+  /* chunks of CHUNK_SIZE bytes, aligned for direct I/O */
+  std::deque< unsigned char * > _free;
+  std::deque< unsigned char * > _full;
+  unsigned char *_cur;
+  size_t _cur_len;
+
+  boost::mutex _mutex;
+  boost::condition_variable _cond;
+  gruel::thread _thread;
+  bool _running;
+
+  uint64_t _written;
+  uint64_t _dropped;
+};
+
+typedef boost::shared_ptr< osmosdr_recorder > osmosdr_recorder_sptr;
+
+/*!
+ * Creates a recorder if the device arguments ask for one, that is record=
+ * and optionally record_rotate= (in bytes) are given. Returns an empty
+ * pointer otherwise. The recording is compressed when the file name ends
+ * in .zst or record_compress= gives a zstd compression level.
+ */
+osmosdr_recorder_sptr make_recorder_from_args( dict_t &dict, const std::string &format );
+
+#endif // OSMOSDR_RECORDER_H
@@ -0,0 +1,129 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2013 Dimitri Stolnikov <horiz0n@gmx.net>
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdexcept>
+
+#include <boost/bind.hpp>
+
+#include "osmosdr_setter_queue.h"
+
+osmosdr_setter_queue::osmosdr_setter_queue()
+  : _running(true)
+{
+  _thread = gruel::thread( boost::bind( &osmosdr_setter_queue::worker, this ) );
+}
+
+osmosdr_setter_queue::~osmosdr_setter_queue()
+{
+  stop();
+}
+
+void osmosdr_setter_queue::stop()
+{
+  {
+    boost::mutex::scoped_lock lock( _mutex );
+    _running = false;
+  }
+
+  _cond.notify_all();
+
+  if ( _thread.joinable() )
+    _thread.join();
+}
+
+osmosdr_future_t osmosdr_setter_queue::post( const std::string &key, setter_t setter )
+{
+  if ( boost::this_thread::get_id() == _thread.get_id() ) {
+    boost::promise< double > promise;
+
+    try {
+      promise.set_value( setter() );
+    } catch ( ... ) {
+      promise.set_exception( boost::current_exception() );
+    }
+
+    return osmosdr_future_t( promise.get_future() );
+  }
+
+  boost::mutex::scoped_lock lock( _mutex );
+
+  if ( ! _running )
+    throw std::runtime_error( "The device has been closed." );
+
+  std::map< std::string, pending_t >::iterator it = _pending.find( key );
+
+  if ( it != _pending.end() ) {
+    /* not started yet, the latest value wins */
+    it->second.setter = setter;
+    return it->second.future;
+  }
+
+  pending_t &pending = _pending[ key ];
+  pending.setter = setter;
+  pending.promise.reset( new boost::promise< double >() );
+  pending.future = osmosdr_future_t( pending.promise->get_future() );
+
+  _order.push_back( key );
+  _cond.notify_one();
+
+  return pending.future;
+}
+
+double osmosdr_setter_queue::call( const std::string &key, setter_t setter )
+{
+  osmosdr_future_t future = post( key, setter );
+
+  return future.get();
+}
+
+void osmosdr_setter_queue::worker()
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  while ( true ) {
+    if ( _order.empty() ) {
+      if ( ! _running )
+        break;
+
+      _cond.wait( lock );
+      continue;
+    }
+
+    std::string key = _order.front();
+    _order.pop_front();
+
+    pending_t pending = _pending[ key ];
+    _pending.erase( key );
+
+    lock.unlock();
+
+    try {
+      pending.promise->set_value( pending.setter() );
+    } catch ( ... ) {
+      pending.promise->set_exception( boost::current_exception() );
+    }
+
+    lock.lock();
+  }
+}
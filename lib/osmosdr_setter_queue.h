@@ -0,0 +1,85 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2013 Dimitri Stolnikov <horiz0n@gmx.net>
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_SETTER_QUEUE_H
+#define OSMOSDR_SETTER_QUEUE_H
+
+#include <string>
+#include <deque>
+#include <map>
+
+#include <gruel/thread.h>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/future.hpp>
+
+#include <osmosdr/osmosdr_source_c.h> /* osmosdr_future_t */
+
+/*!
+ * Runs the hardware setters of a device on a control thread of its own.
+ *
+ * Every setting is queued under a key naming the parameter. While a setting
+ * waits for its turn, another one with the same key replaces it, and all
+ * callers waiting for either get the result of the latest. A burst of
+ * settings, like the ones a slider produces while being dragged, thus
+ * costs a single control transfer once the device is free again.
+ *
+ * Settings with different keys are applied in the order they were first
+ * queued. A setter which calls another one from the control thread runs
+ * it right away.
+ */
+class osmosdr_setter_queue
+{
+public:
+  typedef boost::function< double ( void ) > setter_t;
+
+  osmosdr_setter_queue();
+  ~osmosdr_setter_queue();
+
+  /* queues the setter and returns at once */
+  osmosdr_future_t post( const std::string &key, setter_t setter );
+
+  /* queues the setter and waits for its result */
+  double call( const std::string &key, setter_t setter );
+
+  /* applies what is queued and ends the control thread, settings queued
+   * later fail. Owners call this before closing the device. */
+  void stop();
+
+private:
+  struct pending_t {
+    setter_t setter;
+    boost::shared_ptr< boost::promise< double > > promise;
+    osmosdr_future_t future;
+  };
+
+  void worker();
+
+  std::deque< std::string > _order;
+  std::map< std::string, pending_t > _pending;
+  bool _running;
+
+  boost::mutex _mutex;
+  boost::condition_variable _cond;
+  gruel::thread _thread;
+};
+
+#endif // OSMOSDR_SETTER_QUEUE_H
@@ -32,8 +32,15 @@
 #include <gnuradio/gr_throttle.h>
 #include <gnuradio/gr_null_sink.h>
 
+#include <algorithm>
+
+#include <boost/bind.hpp>
+
 #include "osmosdr_sink_c_impl.h"
 
+#ifdef ENABLE_FILE
+#include <file_sink_c.h>
+#endif
 #ifdef ENABLE_UHD
 #include "uhd_sink_c.h"
 #endif
@@ -45,6 +52,8 @@
 #endif
 
 #include "osmosdr_arg_helpers.h"
+#include "osmosdr_device_cache.h"
+#include "osmosdr_parallel.h"
 
 /* This avoids throws in ctor of gr_hier_block2, as gnuradio is unable to deal
  with this behavior in a clean way. The GR maintainer Rondeau has been informed. */
@@ -60,13 +69,46 @@ osmosdr_make_sink_c (const std::string &args)
   return gnuradio::get_initial_sptr(new osmosdr_sink_c_impl (args));
 }
 
+/* constructs the backend the arguments ask for */
+static void make_device( const std::string &arg,
+                         gr_basic_block_sptr &block, osmosdr_snk_iface *&iface )
+{
+  dict_t dict = params_to_dict(arg);
+
+#ifdef ENABLE_FILE
+  if ( dict.count("file") ) {
+    file_sink_c_sptr sink = make_file_sink_c( arg );
+    block = sink; iface = sink.get();
+  }
+#endif
+#ifdef ENABLE_UHD
+  if ( dict.count("uhd") ) {
+    uhd_sink_c_sptr sink = make_uhd_sink_c( arg );
+    block = sink; iface = sink.get();
+  }
+#endif
+#ifdef ENABLE_HACKRF
+  if ( dict.count("hackrf") ) {
+    hackrf_sink_c_sptr sink = make_hackrf_sink_c( arg );
+    block = sink; iface = sink.get();
+  }
+#endif
+#ifdef ENABLE_BLADERF
+  if ( dict.count("bladerf") ) {
+    bladerf_sink_c_sptr sink = make_bladerf_sink_c( arg );
+    block = sink; iface = sink.get();
+  }
+#endif
+}
+
 /*
  * The private constructor
  */
 osmosdr_sink_c_impl::osmosdr_sink_c_impl (const std::string &args)
   : gr_hier_block2 ("osmosdr_sink_c_impl",
         args_to_io_signature(args),
-        gr_make_io_signature (0, 0, 0))
+        gr_make_io_signature (0, 0, 0)),
+    _control( make_osmosdr_control( boost::bind( &osmosdr_sink_c_impl::apply_command, this, _1 ) ) )
 {
   size_t channel = 0;
   bool device_specified = false;
@@ -75,6 +117,9 @@ osmosdr_sink_c_impl::osmosdr_sink_c_impl (const std::string &args)
 
   std::vector< std::string > dev_types;
 
+#ifdef ENABLE_FILE
+  dev_types.push_back("file");
+#endif
 #ifdef ENABLE_UHD
   dev_types.push_back("uhd");
 #endif
@@ -105,64 +150,46 @@ osmosdr_sink_c_impl::osmosdr_sink_c_impl (const std::string &args)
 #ifdef WORKAROUND_GR_HIER_BLOCK2_BUG
   try {
 #endif
-  std::vector< std::string > dev_list;
+  if (!device_specified) {
+    /* only the first device found is going to be used, stop probing there */
+    std::vector< std::string > dev_list;
 #ifdef ENABLE_UHD
-  BOOST_FOREACH( std::string dev, uhd_sink_c::get_devices() )
-    dev_list.push_back( dev );
+    if ( dev_list.empty() )
+      dev_list = cached_get_devices( "uhd_sink_c", &uhd_sink_c::get_devices );
 #endif
 #ifdef ENABLE_HACKRF
-  BOOST_FOREACH( std::string dev, hackrf_sink_c::get_devices() )
-    dev_list.push_back( dev );
+    if ( dev_list.empty() )
+      dev_list = cached_get_devices( "hackrf_sink_c", &hackrf_sink_c::get_devices );
 #endif
 #ifdef ENABLE_BLADERF
-  BOOST_FOREACH( std::string dev, bladerf_sink_c::get_devices() )
-    dev_list.push_back( dev );
+    if ( dev_list.empty() )
+      dev_list = cached_get_devices( "bladerf_sink_c", &bladerf_sink_c::get_devices );
 #endif
-//  std::cerr << std::endl;
-//  BOOST_FOREACH( std::string dev, dev_list )
-//    std::cerr << "'" << dev << "'" << std::endl;
+//    std::cerr << std::endl;
+//    BOOST_FOREACH( std::string dev, dev_list )
+//      std::cerr << "'" << dev << "'" << std::endl;
 
-  if (!device_specified) {
     if ( dev_list.size() )
       arg_list.push_back( dev_list.front() );
     else
       throw std::runtime_error("No supported devices found to pick from.");
   }
 
+  /* none of the sinks takes long to open, they are built in order */
   BOOST_FOREACH(std::string arg, arg_list) {
 
-    dict_t dict = params_to_dict(arg);
-
-//    std::cerr << std::endl;
-//    BOOST_FOREACH( dict_t::value_type &entry, dict )
-//      std::cerr << "'" << entry.first << "' = '" << entry.second << "'" << std::endl;
-
     osmosdr_snk_iface *iface = NULL;
     gr_basic_block_sptr block;
 
-#ifdef ENABLE_UHD
-    if ( dict.count("uhd") ) {
-      uhd_sink_c_sptr sink = make_uhd_sink_c( arg );
-      block = sink; iface = sink.get();
-    }
-#endif
-#ifdef ENABLE_HACKRF
-    if ( dict.count("hackrf") ) {
-      hackrf_sink_c_sptr sink = make_hackrf_sink_c( arg );
-      block = sink; iface = sink.get();
-    }
-#endif
-#ifdef ENABLE_BLADERF
-    if ( dict.count("bladerf") ) {
-      bladerf_sink_c_sptr sink = make_bladerf_sink_c( arg );
-      block = sink; iface = sink.get();
-    }
-#endif
+    make_device( arg, block, iface );
 
     if ( iface != NULL && long(block.get()) != 0 ) {
       _devs.push_back( iface );
 
       for (size_t i = 0; i < iface->get_num_channels(); i++) {
+        route_t route = { iface, i };
+        _routes.push_back( route );
+
         connect(self(), channel++, block, i);
       }
     } else if ( (iface != NULL) || (long(block.get()) != 0) )
@@ -196,16 +223,14 @@ osmosdr_sink_c_impl::osmosdr_sink_c_impl (const std::string &args)
     }
   }
 #endif
+
+  /* a stand-alone block, the scheduler gives it a thread to take commands on */
+  connect( _control );
 }
 
 size_t osmosdr_sink_c_impl::get_num_channels()
 {
-  size_t channels = 0;
-
-  BOOST_FOREACH( osmosdr_snk_iface *dev, _devs )
-    channels += dev->get_num_channels();
-
-  return channels;
+  return _routes.size();
 }
 
 #define NO_DEVICES_MSG  "FATAL: No device(s) available to work with."
@@ -223,6 +248,8 @@ osmosdr::meta_range_t osmosdr_sink_c_impl::get_sample_rates()
 
 double osmosdr_sink_c_impl::set_sample_rate(double rate)
 {
+  boost::recursive_mutex::scoped_lock lock( _mutex );
+
   double sample_rate = 0;
 
   if (_sample_rate != rate) {
@@ -230,8 +257,18 @@ double osmosdr_sink_c_impl::set_sample_rate(double rate)
     if (_devs.empty())
       throw std::runtime_error(NO_DEVICES_MSG);
 #endif
-    BOOST_FOREACH( osmosdr_snk_iface *dev, _devs )
-      sample_rate = dev->set_sample_rate(rate);
+    /* all devices at once, a group retune costs about as much as a single one */
+    std::vector< double > rates( _devs.size() );
+    std::vector< parallel_job_t > jobs;
+
+    for (size_t i = 0; i < _devs.size(); i++)
+      jobs.push_back( boost::bind( &osmosdr_sink_c_impl::apply_sample_rate, _devs[i], rate,
+                                   boost::ref( rates[i] ) ) );
+
+    throw_first_error( run_parallel( jobs, jobs.size() ) );
+
+    if ( rates.size() )
+      sample_rate = rates.back();
 
     _sample_rate = sample_rate;
   }
@@ -239,6 +276,11 @@ double osmosdr_sink_c_impl::set_sample_rate(double rate)
   return sample_rate;
 }
 
+void osmosdr_sink_c_impl::apply_sample_rate( osmosdr_snk_iface *dev, double rate, double &actual )
+{
+  actual = dev->set_sample_rate( rate );
+}
+
 double osmosdr_sink_c_impl::get_sample_rate()
 {
   double sample_rate = 0;
@@ -254,233 +296,185 @@ double osmosdr_sink_c_impl::get_sample_rate()
 
 osmosdr::freq_range_t osmosdr_sink_c_impl::get_freq_range( size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( osmosdr_snk_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_freq_range( dev_chan );
+  if ( chan < _routes.size() )
+    return _routes[chan].dev->get_freq_range( _routes[chan].dev_chan );
 
   return osmosdr::freq_range_t();
 }
 
 double osmosdr_sink_c_impl::set_center_freq( double freq, size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( osmosdr_snk_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        if ( _center_freq[ chan ] != freq ) {
-          _center_freq[ chan ] = freq;
-          return dev->set_center_freq( freq, dev_chan );
-        }
+  boost::recursive_mutex::scoped_lock lock( _mutex );
+
+  if ( chan < _routes.size() && _center_freq[ chan ] != freq ) {
+    _center_freq[ chan ] = freq;
+    return _routes[chan].dev->set_center_freq( freq, _routes[chan].dev_chan );
+  }
 
   return 0;
 }
 
 double osmosdr_sink_c_impl::get_center_freq( size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( osmosdr_snk_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_center_freq( dev_chan );
+  if ( chan < _routes.size() )
+    return _routes[chan].dev->get_center_freq( _routes[chan].dev_chan );
 
   return 0;
 }
 
 double osmosdr_sink_c_impl::set_freq_corr( double ppm, size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( osmosdr_snk_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        if ( _freq_corr[ chan ] != ppm ) {
-          _freq_corr[ chan ] = ppm;
-          return dev->set_freq_corr( ppm, dev_chan );
-        }
+  boost::recursive_mutex::scoped_lock lock( _mutex );
+
+  if ( chan < _routes.size() && _freq_corr[ chan ] != ppm ) {
+    _freq_corr[ chan ] = ppm;
+    return _routes[chan].dev->set_freq_corr( ppm, _routes[chan].dev_chan );
+  }
 
   return 0;
 }
 
 double osmosdr_sink_c_impl::get_freq_corr( size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( osmosdr_snk_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_freq_corr( dev_chan );
+  if ( chan < _routes.size() )
+    return _routes[chan].dev->get_freq_corr( _routes[chan].dev_chan );
 
   return 0;
 }
 
 std::vector<std::string> osmosdr_sink_c_impl::get_gain_names( size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( osmosdr_snk_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_gain_names( dev_chan );
+  if ( chan < _routes.size() )
+    return _routes[chan].dev->get_gain_names( _routes[chan].dev_chan );
 
   return std::vector< std::string >();
 }
 
 osmosdr::gain_range_t osmosdr_sink_c_impl::get_gain_range( size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( osmosdr_snk_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_gain_range( dev_chan );
+  if ( chan < _routes.size() )
+    return _routes[chan].dev->get_gain_range( _routes[chan].dev_chan );
 
   return osmosdr::gain_range_t();
 }
 
 osmosdr::gain_range_t osmosdr_sink_c_impl::get_gain_range( const std::string & name, size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( osmosdr_snk_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_gain_range( name, dev_chan );
+  if ( chan < _routes.size() )
+    return _routes[chan].dev->get_gain_range( name, _routes[chan].dev_chan );
 
   return osmosdr::gain_range_t();
 }
 
 bool osmosdr_sink_c_impl::set_gain_mode( bool automatic, size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( osmosdr_snk_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        if ( _gain_mode[ chan ] != automatic ) {
-          _gain_mode[ chan ] = automatic;
-          bool mode = dev->set_gain_mode( automatic, dev_chan );
-          if (!automatic) // reapply gain value when switched to manual mode
-            dev->set_gain( _gain[ chan ], dev_chan );
-          return mode;
-        }
+  boost::recursive_mutex::scoped_lock lock( _mutex );
+
+  if ( chan < _routes.size() && _gain_mode[ chan ] != automatic ) {
+    _gain_mode[ chan ] = automatic;
+    bool mode = _routes[chan].dev->set_gain_mode( automatic, _routes[chan].dev_chan );
+    if (!automatic) // reapply gain value when switched to manual mode
+      _routes[chan].dev->set_gain( _gain[ chan ], _routes[chan].dev_chan );
+    return mode;
+  }
 
   return false;
 }
 
 bool osmosdr_sink_c_impl::get_gain_mode( size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( osmosdr_snk_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_gain_mode( dev_chan );
+  if ( chan < _routes.size() )
+    return _routes[chan].dev->get_gain_mode( _routes[chan].dev_chan );
 
   return false;
 }
 
 double osmosdr_sink_c_impl::set_gain( double gain, size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( osmosdr_snk_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        if ( _gain[ chan ] != gain ) {
-          _gain[ chan ] = gain;
-          return dev->set_gain( gain, dev_chan );
-        }
+  boost::recursive_mutex::scoped_lock lock( _mutex );
+
+  if ( chan < _routes.size() && _gain[ chan ] != gain ) {
+    _gain[ chan ] = gain;
+    return _routes[chan].dev->set_gain( gain, _routes[chan].dev_chan );
+  }
 
   return 0;
 }
 
 double osmosdr_sink_c_impl::set_gain( double gain, const std::string & name, size_t chan)
 {
-  size_t channel = 0;
-  BOOST_FOREACH( osmosdr_snk_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->set_gain( gain, name, dev_chan );
+  boost::recursive_mutex::scoped_lock lock( _mutex );
+
+  if ( chan < _routes.size() )
+    return _routes[chan].dev->set_gain( gain, name, _routes[chan].dev_chan );
 
   return 0;
 }
 
 double osmosdr_sink_c_impl::get_gain( size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( osmosdr_snk_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_gain( dev_chan );
+  if ( chan < _routes.size() )
+    return _routes[chan].dev->get_gain( _routes[chan].dev_chan );
 
   return 0;
 }
 
 double osmosdr_sink_c_impl::get_gain( const std::string & name, size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( osmosdr_snk_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_gain( name, dev_chan );
+  if ( chan < _routes.size() )
+    return _routes[chan].dev->get_gain( name, _routes[chan].dev_chan );
 
   return 0;
 }
 
 double osmosdr_sink_c_impl::set_if_gain( double gain, size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( osmosdr_snk_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        if ( _if_gain[ chan ] != gain ) {
-          _if_gain[ chan ] = gain;
-          return dev->set_if_gain( gain, dev_chan );
-        }
+  boost::recursive_mutex::scoped_lock lock( _mutex );
+
+  if ( chan < _routes.size() && _if_gain[ chan ] != gain ) {
+    _if_gain[ chan ] = gain;
+    return _routes[chan].dev->set_if_gain( gain, _routes[chan].dev_chan );
+  }
 
   return 0;
 }
 
 double osmosdr_sink_c_impl::set_bb_gain( double gain, size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( osmosdr_snk_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        if ( _bb_gain[ chan ] != gain ) {
-          _bb_gain[ chan ] = gain;
-          return dev->set_bb_gain( gain, dev_chan );
-        }
+  boost::recursive_mutex::scoped_lock lock( _mutex );
+
+  if ( chan < _routes.size() && _bb_gain[ chan ] != gain ) {
+    _bb_gain[ chan ] = gain;
+    return _routes[chan].dev->set_bb_gain( gain, _routes[chan].dev_chan );
+  }
 
   return 0;
 }
 
 std::vector< std::string > osmosdr_sink_c_impl::get_antennas( size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( osmosdr_snk_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_antennas( dev_chan );
+  if ( chan < _routes.size() )
+    return _routes[chan].dev->get_antennas( _routes[chan].dev_chan );
 
   return std::vector< std::string >();
 }
 
 std::string osmosdr_sink_c_impl::set_antenna( const std::string & antenna, size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( osmosdr_snk_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        if ( _antenna[ chan ] != antenna ) {
-          _antenna[ chan ] = antenna;
-          return dev->set_antenna( antenna, dev_chan );
-        }
+  boost::recursive_mutex::scoped_lock lock( _mutex );
+
+  if ( chan < _routes.size() && _antenna[ chan ] != antenna ) {
+    _antenna[ chan ] = antenna;
+    return _routes[chan].dev->set_antenna( antenna, _routes[chan].dev_chan );
+  }
 
   return "";
 }
 
 std::string osmosdr_sink_c_impl::get_antenna( size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( osmosdr_snk_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_antenna( dev_chan );
+  if ( chan < _routes.size() )
+    return _routes[chan].dev->get_antenna( _routes[chan].dev_chan );
 
   return "";
 }
@@ -495,38 +489,191 @@ void osmosdr_sink_c_impl::set_iq_balance( const std::complex<double> &correction
 
 }
 
+void osmosdr_sink_c_impl::set_dc_offset_mode( int mode, size_t chan )
+{
+
+}
+
+void osmosdr_sink_c_impl::set_dc_offset( const std::complex<double> &offset, size_t chan )
+{
+
+}
+
 double osmosdr_sink_c_impl::set_bandwidth( double bandwidth, size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( osmosdr_snk_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        if ( _bandwidth[ chan ] != bandwidth ) {
-          _bandwidth[ chan ] = bandwidth;
-          return dev->set_bandwidth( bandwidth, dev_chan );
-        }
+  boost::recursive_mutex::scoped_lock lock( _mutex );
+
+  if ( chan < _routes.size() && _bandwidth[ chan ] != bandwidth ) {
+    _bandwidth[ chan ] = bandwidth;
+    return _routes[chan].dev->set_bandwidth( bandwidth, _routes[chan].dev_chan );
+  }
 
   return 0;
 }
 
 double osmosdr_sink_c_impl::get_bandwidth( size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( osmosdr_snk_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_bandwidth( dev_chan );
+  if ( chan < _routes.size() )
+    return _routes[chan].dev->get_bandwidth( _routes[chan].dev_chan );
 
   return 0;
 }
 
 osmosdr::freq_range_t osmosdr_sink_c_impl::get_bandwidth_range( size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( osmosdr_snk_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_bandwidth_range( dev_chan );
+  if ( chan < _routes.size() )
+    return _routes[chan].dev->get_bandwidth_range( _routes[chan].dev_chan );
 
   return osmosdr::freq_range_t();
 }
+
+std::vector< double > osmosdr_sink_c_impl::set_center_freqs( const std::vector< double > &freqs )
+{
+  boost::recursive_mutex::scoped_lock lock( _mutex );
+
+  return set_channels( freqs, _center_freq,
+                       &osmosdr_snk_iface::set_center_freq, &osmosdr_snk_iface::get_center_freq );
+}
+
+std::vector< double > osmosdr_sink_c_impl::set_gains( const std::vector< double > &gains )
+{
+  boost::recursive_mutex::scoped_lock lock( _mutex );
+
+  return set_channels( gains, _gain,
+                       &osmosdr_snk_iface::set_gain, &osmosdr_snk_iface::get_gain );
+}
+
+std::vector< double > osmosdr_sink_c_impl::set_bandwidths( const std::vector< double > &bandwidths )
+{
+  boost::recursive_mutex::scoped_lock lock( _mutex );
+
+  return set_channels( bandwidths, _bandwidth,
+                       &osmosdr_snk_iface::set_bandwidth, &osmosdr_snk_iface::get_bandwidth );
+}
+
+void osmosdr_sink_c_impl::apply_batch( device_batch_t &batch )
+{
+  for (size_t i = 0; i < batch.dev_chans.size(); i++)
+    batch.actual[i] = (batch.dev->*batch.setter)( batch.values[i], batch.dev_chans[i] );
+}
+
+std::vector< double > osmosdr_sink_c_impl::set_channels( const std::vector< double > &values,
+                                                   std::map< size_t, double > &cache,
+                                                   channel_setter_t setter,
+                                                   channel_getter_t getter )
+{
+  size_t count = std::min( values.size(), _routes.size() );
+  std::vector< double > actual( count );
+  std::vector< bool > changed( count, false );
+
+  std::vector< device_batch_t > batches;
+  std::map< osmosdr_snk_iface *, size_t > batch_of;
+
+  for (size_t chan = 0; chan < count; chan++) {
+    if ( cache.count( chan ) && cache[ chan ] == values[ chan ] )
+      continue;
+
+    cache[ chan ] = values[ chan ];
+    changed[ chan ] = true;
+
+    const route_t &route = _routes[chan];
+
+    if ( ! batch_of.count( route.dev ) ) {
+      batch_of[ route.dev ] = batches.size();
+      device_batch_t batch;
+      batch.dev = route.dev;
+      batch.setter = setter;
+      batches.push_back( batch );
+    }
+
+    device_batch_t &batch = batches[ batch_of[ route.dev ] ];
+    batch.chans.push_back( chan );
+    batch.dev_chans.push_back( route.dev_chan );
+    batch.values.push_back( values[ chan ] );
+    batch.actual.push_back( 0 );
+  }
+
+  /* all devices at once, so they change over at about the same time */
+  std::vector< parallel_job_t > jobs;
+  for (size_t i = 0; i < batches.size(); i++)
+    jobs.push_back( boost::bind( &osmosdr_sink_c_impl::apply_batch, boost::ref( batches[i] ) ) );
+
+  std::vector< std::string > errors = run_parallel( jobs, jobs.size() );
+
+  for (size_t i = 0; i < batches.size(); i++) {
+    for (size_t j = 0; j < batches[i].chans.size(); j++) {
+      if ( errors[i].length() )
+        cache.erase( batches[i].chans[j] ); /* unknown state, don't skip next time */
+      else
+        actual[ batches[i].chans[j] ] = batches[i].actual[j];
+    }
+  }
+
+  throw_first_error( errors );
+
+  for (size_t chan = 0; chan < count; chan++)
+    if ( ! changed[ chan ] )
+      actual[ chan ] = (_routes[chan].dev->*getter)( _routes[chan].dev_chan );
+
+  return actual;
+}
+
+pmt::pmt_t osmosdr_sink_c_impl::apply_command( pmt::pmt_t cmd )
+{
+  /* the whole command at once, in between the calls of other threads */
+  boost::recursive_mutex::scoped_lock lock( _mutex );
+
+  if ( ! pmt::pmt_is_dict( cmd ) )
+    throw std::runtime_error( "Commands are expected to be PMT dicts." );
+
+  pmt::pmt_t status = pmt::pmt_make_dict();
+  double chan = 0, value;
+  std::string antenna;
+
+  try {
+    command_get( cmd, "chan", chan );
+    status = pmt::pmt_dict_add( status, pmt::pmt_intern( "chan" ),
+                                pmt::pmt_from_long( long(chan) ) );
+
+    /* the rate goes first, it may change the bandwidth */
+    if ( command_get( cmd, "rate", value ) ) {
+      set_sample_rate( value );
+      status = pmt::pmt_dict_add( status, pmt::pmt_intern( "rate" ),
+                                  pmt::pmt_from_double( get_sample_rate() ) );
+    }
+
+    if ( command_get( cmd, "freq", value ) ) {
+      set_center_freq( value, size_t(chan) );
+      status = pmt::pmt_dict_add( status, pmt::pmt_intern( "freq" ),
+                                  pmt::pmt_from_double( get_center_freq( size_t(chan) ) ) );
+    }
+
+    if ( command_get( cmd, "gain", value ) ) {
+      set_gain( value, size_t(chan) );
+      status = pmt::pmt_dict_add( status, pmt::pmt_intern( "gain" ),
+                                  pmt::pmt_from_double( get_gain( size_t(chan) ) ) );
+    }
+
+    if ( command_get( cmd, "bandwidth", value ) ) {
+      set_bandwidth( value, size_t(chan) );
+      status = pmt::pmt_dict_add( status, pmt::pmt_intern( "bandwidth" ),
+                                  pmt::pmt_from_double( get_bandwidth( size_t(chan) ) ) );
+    }
+
+    if ( command_get( cmd, "antenna", antenna ) ) {
+      set_antenna( antenna, size_t(chan) );
+      status = pmt::pmt_dict_add( status, pmt::pmt_intern( "antenna" ),
+                                  pmt::pmt_intern( get_antenna( size_t(chan) ) ) );
+    }
+  } catch ( std::exception &ex ) {
+    status = pmt::pmt_dict_add( status, pmt::pmt_intern( "error" ),
+                                pmt::pmt_intern( ex.what() ) );
+  }
+
+  return status;
+}
+
+gr_basic_block_sptr osmosdr_sink_c_impl::control_block()
+{
+  return _control;
+}
@@ -23,9 +23,12 @@
 #include "osmosdr/osmosdr_sink_c.h"
 
 #include "osmosdr_snk_iface.h"
+#include "osmosdr_control.h"
 
 #include <map>
 
+#include <boost/thread/recursive_mutex.hpp>
+
 class osmosdr_sink_c_impl : public osmosdr_sink_c
 {
 public:
@@ -61,10 +64,19 @@ public:
   void set_iq_balance_mode( int mode, size_t chan = 0 );
   void set_iq_balance( const std::complex<double> &correction, size_t chan = 0 );
 
+  void set_dc_offset_mode( int mode, size_t chan = 0 );
+  void set_dc_offset( const std::complex<double> &offset, size_t chan = 0 );
+
   double set_bandwidth( double bandwidth, size_t chan = 0 );
   double get_bandwidth( size_t chan = 0 );
   osmosdr::freq_range_t get_bandwidth_range( size_t chan = 0 );
 
+  std::vector< double > set_center_freqs( const std::vector< double > &freqs );
+  std::vector< double > set_gains( const std::vector< double > &gains );
+  std::vector< double > set_bandwidths( const std::vector< double > &bandwidths );
+
+  gr_basic_block_sptr control_block( void );
+
 private:
   osmosdr_sink_c_impl (const std::string & args);  	// private constructor
 
@@ -74,6 +86,34 @@ private:
 
   std::vector< osmosdr_snk_iface * > _devs;
 
+  /* maps a channel of the group to the device serving it */
+  struct route_t {
+    osmosdr_snk_iface *dev;
+    size_t dev_chan;
+  };
+  std::vector< route_t > _routes;
+
+  typedef double (osmosdr_snk_iface::*channel_setter_t)( double, size_t );
+  typedef double (osmosdr_snk_iface::*channel_getter_t)( size_t );
+
+  /* the changed channels of one device, set in order on a pool thread */
+  struct device_batch_t {
+    osmosdr_snk_iface *dev;
+    channel_setter_t setter;
+    std::vector< size_t > chans;
+    std::vector< size_t > dev_chans;
+    std::vector< double > values;
+    std::vector< double > actual;
+  };
+
+  static void apply_batch( device_batch_t &batch );
+  static void apply_sample_rate( osmosdr_snk_iface *dev, double rate, double &actual );
+
+  std::vector< double > set_channels( const std::vector< double > &values,
+                                      std::map< size_t, double > &cache,
+                                      channel_setter_t setter,
+                                      channel_getter_t getter );
+
   double _sample_rate;
   std::map< size_t, double > _center_freq;
   std::map< size_t, double > _freq_corr;
@@ -83,6 +123,13 @@ private:
   std::map< size_t, double > _bb_gain;
   std::map< size_t, std::string > _antenna;
   std::map< size_t, double > _bandwidth;
+
+  /* serializes the setters, called from user threads and from _control */
+  boost::recursive_mutex _mutex;
+
+  pmt::pmt_t apply_command( pmt::pmt_t cmd );
+
+  osmosdr_control_sptr _control;
 };
 
 #endif /* INCLUDED_OSMOSDR_SINK_C_IMPL_H */
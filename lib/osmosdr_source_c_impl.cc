@@ -31,8 +31,18 @@
 #include <gr_io_signature.h>
 #include <gr_noise_source_c.h>
 #include <gr_throttle.h>
+#include <gr_stream_to_streams.h>
+#include <gr_pfb_channelizer_ccf.h>
+#include <gr_firdes.h>
+#ifdef HAVE_IQBALANCE
+#include <gr_keep_m_in_n.h>
+#endif
 #include <gnuradio/gr_constants.h>
 
+#include <algorithm>
+
+#include <boost/bind.hpp>
+
 #ifdef ENABLE_OSMOSDR
 #include <osmosdr_src_c.h>
 #endif
@@ -53,6 +63,10 @@
 #include <rtl_tcp_source_c.h>
 #endif
 
+#ifdef ENABLE_UDP
+#include <udp_source_c.h>
+#endif
+
 #ifdef ENABLE_UHD
 #include <uhd_source_c.h>
 #endif
@@ -70,6 +84,8 @@
 #endif
 
 #include <osmosdr_arg_helpers.h>
+#include <osmosdr_device_cache.h>
+#include <osmosdr_parallel.h>
 
 /* This avoids throws in ctor of gr_hier_block2, as gnuradio is unable to deal
  with this behavior in a clean way. The GR maintainer Rondeau has been informed. */
@@ -85,13 +101,125 @@ osmosdr_make_source_c (const std::string &args)
   return gnuradio::get_initial_sptr(new osmosdr_source_c_impl (args));
 }
 
+/* hardware opened ahead of its block, by open_device() */
+struct opened_t
+{
+#ifdef ENABLE_RTL
+  rtlsdr_dev_t *rtl;
+#endif
+
+  opened_t()
+  {
+#ifdef ENABLE_RTL
+    rtl = NULL;
+#endif
+  }
+};
+
+/* the slow setup of backends which can do it apart from their block,
+ * runs on a pool thread */
+static void open_device( const std::string &arg, opened_t &opened )
+{
+  dict_t dict = params_to_dict(arg);
+
+#ifdef ENABLE_RTL
+  if ( dict.count("rtl") )
+    opened.rtl = rtl_source_c::open_device( arg );
+#endif
+}
+
+/* constructs the backend the arguments ask for, taking over what was opened */
+static void make_device( const std::string &arg, opened_t &opened,
+                         gr_basic_block_sptr &block, osmosdr_src_iface *&iface )
+{
+  dict_t dict = params_to_dict(arg);
+
+#ifdef ENABLE_OSMOSDR
+  if ( dict.count("osmosdr") ) {
+    osmosdr_src_c_sptr src = osmosdr_make_src_c( arg );
+    block = src; iface = src.get();
+  }
+#endif
+
+#ifdef ENABLE_FCD
+  if ( dict.count("fcd") ) {
+    fcd_source_sptr src = make_fcd_source( arg );
+    block = src; iface = src.get();
+  }
+#endif
+
+#ifdef ENABLE_FILE
+  if ( dict.count("file") ) {
+    file_source_c_sptr src = make_file_source_c( arg );
+    block = src; iface = src.get();
+  }
+#endif
+
+#ifdef ENABLE_RTL
+  if ( dict.count("rtl") ) {
+    rtlsdr_dev_t *dev = opened.rtl;
+    opened.rtl = NULL; /* the block owns it from now on */
+    rtl_source_c_sptr src = make_rtl_source_c( arg, dev );
+    block = src; iface = src.get();
+  }
+#endif
+
+#ifdef ENABLE_RTL_TCP
+  if ( dict.count("rtl_tcp") ) {
+    rtl_tcp_source_c_sptr src = make_rtl_tcp_source_c( arg );
+    block = src; iface = src.get();
+  }
+#endif
+
+#ifdef ENABLE_UDP
+  if ( dict.count("udp") ) {
+    udp_source_c_sptr src = make_udp_source_c( arg );
+    block = src; iface = src.get();
+  }
+#endif
+
+#ifdef ENABLE_UHD
+  if ( dict.count("uhd") ) {
+    uhd_source_c_sptr src = make_uhd_source_c( arg );
+    block = src; iface = src.get();
+  }
+#endif
+
+#ifdef ENABLE_MIRI
+  if ( dict.count("miri") ) {
+    miri_source_c_sptr src = make_miri_source_c( arg );
+    block = src; iface = src.get();
+  }
+#endif
+
+#ifdef ENABLE_HACKRF
+  if ( dict.count("hackrf") ) {
+    hackrf_source_c_sptr src = make_hackrf_source_c( arg );
+    block = src; iface = src.get();
+  }
+#endif
+
+#ifdef ENABLE_BLADERF
+  if ( dict.count("bladerf") ) {
+    bladerf_source_c_sptr src = make_bladerf_source_c( arg );
+    block = src; iface = src.get();
+  }
+#endif
+}
+
+#ifdef HAVE_IQBALANCE
+/* contiguous samples handed to the optimizer at a time with iqbal_decim= */
+#define IQBAL_CHUNK 8192
+#endif
+
 /*
  * The private constructor
  */
 osmosdr_source_c_impl::osmosdr_source_c_impl (const std::string &args)
   : gr_hier_block2 ("osmosdr_source_c_impl",
         gr_make_io_signature (0, 0, 0),
-        args_to_io_signature(args))
+        args_to_io_signature(args, true)),
+    _control( make_osmosdr_control( boost::bind( &osmosdr_source_c_impl::apply_command, this, _1 ) ) )
 {
   size_t channel = 0;
   bool device_specified = false;
@@ -115,6 +243,9 @@ osmosdr_source_c_impl::osmosdr_source_c_impl (const std::string &args)
 #ifdef ENABLE_RTL_TCP
   dev_types.push_back("rtl_tcp");
 #endif
+#ifdef ENABLE_UDP
+  dev_types.push_back("udp");
+#endif
 #ifdef ENABLE_UHD
   dev_types.push_back("uhd");
 #endif
@@ -148,139 +279,154 @@ osmosdr_source_c_impl::osmosdr_source_c_impl (const std::string &args)
 #ifdef WORKAROUND_GR_HIER_BLOCK2_BUG
   try {
 #endif
-  std::vector< std::string > dev_list;
+  if (!device_specified) {
+    /* only the first device found is going to be used, stop probing there */
+    std::vector< std::string > dev_list;
 #ifdef ENABLE_OSMOSDR
-  BOOST_FOREACH( std::string dev, osmosdr_src_c::get_devices() )
-    dev_list.push_back( dev );
+    if ( dev_list.empty() )
+      dev_list = cached_get_devices( "osmosdr_src_c", &osmosdr_src_c::get_devices );
 #endif
 #ifdef ENABLE_FCD
-  BOOST_FOREACH( std::string dev, fcd_source::get_devices() )
-    dev_list.push_back( dev );
+    if ( dev_list.empty() )
+      dev_list = cached_get_devices( "fcd_source", &fcd_source::get_devices );
 #endif
 #ifdef ENABLE_RTL
-  BOOST_FOREACH( std::string dev, rtl_source_c::get_devices() )
-    dev_list.push_back( dev );
+    if ( dev_list.empty() )
+      dev_list = cached_get_devices( "rtl_source_c", &rtl_source_c::get_devices );
 #endif
 #ifdef ENABLE_UHD
-  BOOST_FOREACH( std::string dev, uhd_source_c::get_devices() )
-    dev_list.push_back( dev );
+    if ( dev_list.empty() )
+      dev_list = cached_get_devices( "uhd_source_c", &uhd_source_c::get_devices );
 #endif
 #ifdef ENABLE_MIRI
-  BOOST_FOREACH( std::string dev, miri_source_c::get_devices() )
-    dev_list.push_back( dev );
+    if ( dev_list.empty() )
+      dev_list = cached_get_devices( "miri_source_c", &miri_source_c::get_devices );
 #endif
 #ifdef ENABLE_HACKRF
-  BOOST_FOREACH( std::string dev, hackrf_source_c::get_devices() )
-    dev_list.push_back( dev );
+    if ( dev_list.empty() )
+      dev_list = cached_get_devices( "hackrf_source_c", &hackrf_source_c::get_devices );
 #endif
 #ifdef ENABLE_BLADERF
-  BOOST_FOREACH( std::string dev, bladerf_source_c::get_devices() )
-    dev_list.push_back( dev );
+    if ( dev_list.empty() )
+      dev_list = cached_get_devices( "bladerf_source_c", &bladerf_source_c::get_devices );
 #endif
-//  std::cerr << std::endl;
-//  BOOST_FOREACH( std::string dev, dev_list )
-//    std::cerr << "'" << dev << "'" << std::endl;
+//    std::cerr << std::endl;
+//    BOOST_FOREACH( std::string dev, dev_list )
+//      std::cerr << "'" << dev << "'" << std::endl;
 
-  if (!device_specified) {
     if ( dev_list.size() )
       arg_list.push_back( dev_list.front() );
     else
       throw std::runtime_error("No supported devices found to pick from.");
   }
 
-  BOOST_FOREACH(std::string arg, arg_list) {
+  /* opening a device takes a while, do all of them at once */
+  std::vector< opened_t > opened( arg_list.size() );
+  std::vector< parallel_job_t > jobs;
 
-    dict_t dict = params_to_dict(arg);
+  for (size_t dev = 0; dev < arg_list.size(); dev++)
+    jobs.push_back( boost::bind( &open_device, boost::cref( arg_list[dev] ),
+                                 boost::ref( opened[dev] ) ) );
 
-//    std::cerr << std::endl;
-//    BOOST_FOREACH( dict_t::value_type &entry, dict )
-//      std::cerr << "'" << entry.first << "' = '" << entry.second << "'" << std::endl;
+  std::vector< std::string > errors = run_parallel( jobs );
 
-    osmosdr_src_iface *iface = NULL;
-    gr_basic_block_sptr block;
+  /* constructing gr blocks isn't thread safe (unique ids, the block registry),
+   * they are built one after the other on this thread */
+  std::vector< gr_basic_block_sptr > blocks( arg_list.size() );
+  std::vector< osmosdr_src_iface * > ifaces( arg_list.size(), (osmosdr_src_iface *)NULL );
 
-#ifdef ENABLE_OSMOSDR
-    if ( dict.count("osmosdr") ) {
-      osmosdr_src_c_sptr src = osmosdr_make_src_c( arg );
-      block = src; iface = src.get();
-    }
-#endif
+  for (size_t dev = 0; dev < arg_list.size(); dev++) {
+    if ( errors[dev].length() )
+      continue;
 
-#ifdef ENABLE_FCD
-    if ( dict.count("fcd") ) {
-      fcd_source_sptr src = make_fcd_source( arg );
-      block = src; iface = src.get();
+    try {
+      make_device( arg_list[dev], opened[dev], blocks[dev], ifaces[dev] );
+    } catch ( std::exception &ex ) {
+      errors[dev] = ex.what();
     }
-#endif
+  }
 
-#ifdef ENABLE_FILE
-    if ( dict.count("file") ) {
-      file_source_c_sptr src = make_file_source_c( arg );
-      block = src; iface = src.get();
-    }
-#endif
+  /* the first failure ends the setup below, make sure the others are seen too */
+  size_t failures = errors.size() - std::count( errors.begin(), errors.end(), std::string() );
+  if ( failures > 1 )
+    for (size_t dev = 0; dev < arg_list.size(); dev++)
+      if ( errors[dev].length() )
+        std::cerr << "Failed to open '" << arg_list[dev] << "': "
+                  << errors[dev] << std::endl;
 
-#ifdef ENABLE_RTL
-    if ( dict.count("rtl") ) {
-      rtl_source_c_sptr src = make_rtl_source_c( arg );
-      block = src; iface = src.get();
-    }
-#endif
+  for (size_t dev = 0; dev < arg_list.size(); dev++) {
 
-#ifdef ENABLE_RTL_TCP
-    if ( dict.count("rtl_tcp") ) {
-      rtl_tcp_source_c_sptr src = make_rtl_tcp_source_c( arg );
-      block = src; iface = src.get();
-    }
-#endif
+    if ( errors[dev].length() )
+      throw std::runtime_error( errors[dev] );
 
-#ifdef ENABLE_UHD
-    if ( dict.count("uhd") ) {
-      uhd_source_c_sptr src = make_uhd_source_c( arg );
-      block = src; iface = src.get();
-    }
-#endif
+    osmosdr_src_iface *iface = ifaces[dev];
+    gr_basic_block_sptr block = blocks[dev];
 
-#ifdef ENABLE_MIRI
-    if ( dict.count("miri") ) {
-      miri_source_c_sptr src = make_miri_source_c( arg );
-      block = src; iface = src.get();
-    }
-#endif
+    if ( iface != NULL && long(block.get()) != 0 ) {
+      _devs.push_back( iface );
 
-#ifdef ENABLE_HACKRF
-    if ( dict.count("hackrf") ) {
-      hackrf_source_c_sptr src = make_hackrf_source_c( arg );
-      block = src; iface = src.get();
-    }
-#endif
+      dict_t dict = params_to_dict( arg_list[dev] );
 
-#ifdef ENABLE_BLADERF
-    if ( dict.count("bladerf") ) {
-      bladerf_source_c_sptr src = make_bladerf_source_c( arg );
-      block = src; iface = src.get();
-    }
-#endif
+      /* with pfb_chans=M every channel of the device becomes M outputs */
+      size_t pfb_chans = 1;
+      if ( dict.count("pfb_chans") )
+        pfb_chans = std::max( size_t(1), boost::lexical_cast< size_t >( dict["pfb_chans"] ) );
 
-    if ( iface != NULL && long(block.get()) != 0 ) {
-      _devs.push_back( iface );
+#ifdef HAVE_IQBALANCE
+      /* the optimizer only needs a statistical estimate, with iqbal_decim=N
+       * it gets one chunk out of every N instead of the whole stream */
+      size_t iq_decim = 1;
+      if ( dict.count("iqbal_decim") )
+        iq_decim = std::max( size_t(1), boost::lexical_cast< size_t >( dict["iqbal_decim"] ) );
+#endif
 
       for (size_t i = 0; i < iface->get_num_channels(); i++) {
+        /* the full band of the channel, corrected */
+        gr_basic_block_sptr band = block;
+        int band_port = i;
+
 #ifdef HAVE_IQBALANCE
         iqbalance_optimize_c_sptr iq_opt = iqbalance_make_optimize_c( 0 );
-        iqbalance_fix_cc_sptr iq_fix = iqbalance_make_fix_cc();
+        iqbalance_fix_cc_sptr iq_fix;
+
+        /* devices converting with the correction applied save a block and a buffer */
+        if ( ! iface->fused_iq_balance() ) {
+          iq_fix = iqbalance_make_fix_cc();
+          connect(block, i, iq_fix, 0);
+          band = iq_fix;
+          band_port = 0;
+        }
 
-        connect(block, i, iq_fix, 0);
-        connect(iq_fix, 0, self(), channel++);
+        if ( iq_decim > 1 ) {
+          gr_keep_m_in_n_sptr keep = \
+              gr_make_keep_m_in_n( sizeof(gr_complex), IQBAL_CHUNK,
+                                   IQBAL_CHUNK * iq_decim, 0 );
+          connect(block, i, keep, 0);
+          connect(keep, 0, iq_opt, 0);
+        } else
+          connect(block, i, iq_opt, 0);
+
+        /* iq_fix takes absolute values from an optimizer seeing raw samples,
+         * a fused device refines its correction by what is left of the error */
+        if ( iq_fix )
+          msg_connect(iq_opt, "iqbal_corr", iq_fix, "iqbal_corr");
+        else
+          msg_connect(iq_opt, "iqbal_corr", block, "iqbal_corr");
+#endif
 
-        connect(block, i, iq_opt, 0);
-        msg_connect(iq_opt, "iqbal_corr", iq_fix, "iqbal_corr");
+        size_t outputs = connect_band( band, band_port, pfb_chans, channel );
 
-        _iq_opt.push_back( iq_opt.get() );
-        _iq_fix.push_back( iq_fix.get() );
-#else
-        connect(block, i, self(), channel++);
+        for (size_t k = 0; k < outputs; k++) {
+          route_t route = { iface, i, k, outputs };
+          _routes.push_back( route );
+#ifdef HAVE_IQBALANCE
+          _iq_opt.push_back( iq_opt.get() );
+          _iq_fix.push_back( iq_fix.get() ); /* NULL if the device corrects */
+          _iq_decim.push_back( iq_decim );
 #endif
+        }
+
+        channel += outputs;
       }
     } else if ( (iface != NULL) || (long(block.get()) != 0) )
       throw std::runtime_error("Eitner iface or block are NULL.");
@@ -314,16 +460,60 @@ osmosdr_source_c_impl::osmosdr_source_c_impl (const std::string &args)
       connect(throttle, 0, self(), channel++);
   }
 #endif
+
+  /* a stand-alone block, the scheduler gives it a thread to take commands on */
+  connect( _control );
 }
 
-size_t osmosdr_source_c_impl::get_num_channels()
+size_t osmosdr_source_c_impl::connect_band( gr_basic_block_sptr band, int port,
+                                            size_t pfb_chans, size_t first )
+{
+  if ( pfb_chans < 2 ) {
+    connect(band, port, self(), first);
+    return 1;
+  }
+
+  /* one polyphase filter and one FFT for all the channels, each channel
+   * is 6 dB down at 80% of the spacing and fully stopped at its edges */
+  std::vector< float > taps = \
+      gr_firdes::low_pass_2( 1.0, 1.0, 0.4 / pfb_chans, 0.2 / pfb_chans, 80,
+                             gr_firdes::WIN_BLACKMAN_hARRIS );
+
+  gr_stream_to_streams_sptr split = \
+      gr_make_stream_to_streams( sizeof(gr_complex), pfb_chans );
+  gr_pfb_channelizer_ccf_sptr pfb = \
+      gr_make_pfb_channelizer_ccf( pfb_chans, taps, 1.0 );
+
+  connect(band, port, split, 0);
+
+  for (size_t k = 0; k < pfb_chans; k++) {
+    connect(split, k, pfb, k);
+    connect(pfb, k, self(), first + k);
+  }
+
+  return pfb_chans;
+}
+
+bool osmosdr_source_c_impl::controls( size_t chan )
 {
-  size_t channels = 0;
+  return chan < _routes.size() && 0 == _routes[chan].output;
+}
+
+double osmosdr_source_c_impl::freq_offset( size_t chan )
+{
+  const route_t &route = _routes[chan];
+  double spacing = route.dev->get_sample_rate() / route.outputs;
 
-  BOOST_FOREACH( osmosdr_src_iface *dev, _devs )
-    channels += dev->get_num_channels();
+  /* the upper half of the channelizer outputs are the negative frequencies */
+  if ( 2 * route.output >= route.outputs )
+    return (double(route.output) - double(route.outputs)) * spacing;
+
+  return route.output * spacing;
+}
 
-  return channels;
+size_t osmosdr_source_c_impl::get_num_channels()
+{
+  return _routes.size();
 }
 
 #define NO_DEVICES_MSG  "FATAL: No device(s) available to work with."
@@ -341,6 +531,8 @@ osmosdr::meta_range_t osmosdr_source_c_impl::get_sample_rates()
 
 double osmosdr_source_c_impl::set_sample_rate(double rate)
 {
+  boost::recursive_mutex::scoped_lock lock( _mutex );
+
   double sample_rate = 0;
 
   if (_sample_rate != rate) {
@@ -348,23 +540,26 @@ double osmosdr_source_c_impl::set_sample_rate(double rate)
     if (_devs.empty())
       throw std::runtime_error(NO_DEVICES_MSG);
 #endif
-    BOOST_FOREACH( osmosdr_src_iface *dev, _devs )
-      sample_rate = dev->set_sample_rate(rate);
+    /* all devices at once, a group retune costs about as much as a single one */
+    std::vector< double > rates( _devs.size() );
+    std::vector< parallel_job_t > jobs;
+
+    for (size_t i = 0; i < _devs.size(); i++)
+      jobs.push_back( boost::bind( &osmosdr_source_c_impl::apply_sample_rate, _devs[i], rate,
+                                   boost::ref( rates[i] ) ) );
+
+    throw_first_error( run_parallel( jobs, jobs.size() ) );
+
+    if ( rates.size() )
+      sample_rate = rates.back();
 
 #ifdef HAVE_IQBALANCE
-    size_t channel = 0;
-    BOOST_FOREACH( osmosdr_src_iface *dev, _devs ) {
-      for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++) {
-        if ( channel < _iq_opt.size() ) {
-          iqbalance_optimize_c *opt = _iq_opt[channel];
-
-          if ( opt->period() > 0 ) { /* optimize is enabled */
-            opt->set_period( dev->get_sample_rate() / 5 );
-            opt->reset();
-          }
-        }
+    for (size_t chan = 0; chan < _routes.size() && chan < _iq_opt.size(); chan++) {
+      iqbalance_optimize_c *opt = _iq_opt[chan];
 
-        channel++;
+      if ( opt->period() > 0 ) { /* optimize is enabled */
+        opt->set_period( iq_period( chan ) );
+        opt->reset();
       }
     }
 #endif
@@ -375,6 +570,11 @@ double osmosdr_source_c_impl::set_sample_rate(double rate)
   return sample_rate;
 }
 
+void osmosdr_source_c_impl::apply_sample_rate( osmosdr_src_iface *dev, double rate, double &actual )
+{
+  actual = dev->set_sample_rate( rate );
+}
+
 double osmosdr_source_c_impl::get_sample_rate()
 {
   double sample_rate = 0;
@@ -390,268 +590,261 @@ double osmosdr_source_c_impl::get_sample_rate()
 
 osmosdr::freq_range_t osmosdr_source_c_impl::get_freq_range( size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( osmosdr_src_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_freq_range( dev_chan );
+  osmosdr::freq_range_t freqs;
 
-  return osmosdr::freq_range_t();
+  if ( chan < _routes.size() ) {
+    osmosdr::freq_range_t dev_freqs = \
+        _routes[chan].dev->get_freq_range( _routes[chan].dev_chan );
+    double offset = freq_offset( chan );
+
+    for (size_t i = 0; i < dev_freqs.size(); i++)
+      freqs.push_back( osmosdr::range_t( dev_freqs[i].start() + offset,
+                                         dev_freqs[i].stop() + offset,
+                                         dev_freqs[i].step() ) );
+  }
+
+  return freqs;
 }
 
 double osmosdr_source_c_impl::set_center_freq( double freq, size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( osmosdr_src_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        if ( _center_freq[ chan ] != freq ) {
-          _center_freq[ chan ] = freq;
-          return dev->set_center_freq( freq, dev_chan );
-        }
+  boost::recursive_mutex::scoped_lock lock( _mutex );
 
-  return 0;
+  if ( controls( chan ) && _center_freq[ chan ] != freq ) {
+    _center_freq[ chan ] = freq;
+    return _routes[chan].dev->set_center_freq( freq, _routes[chan].dev_chan );
+  }
+
+  return get_center_freq( chan );
 }
 
 double osmosdr_source_c_impl::get_center_freq( size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( osmosdr_src_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_center_freq( dev_chan );
+  if ( chan < _routes.size() )
+    return _routes[chan].dev->get_center_freq( _routes[chan].dev_chan ) +
+           freq_offset( chan );
 
   return 0;
 }
 
+/* a future for a value which is known already */
+static osmosdr_future_t ready_future( double value )
+{
+  boost::promise< double > promise;
+  promise.set_value( value );
+  return osmosdr_future_t( promise.get_future() );
+}
+
+osmosdr_future_t osmosdr_source_c_impl::post_center_freq( double freq, size_t chan )
+{
+  boost::recursive_mutex::scoped_lock lock( _mutex );
+
+  if ( controls( chan ) ) {
+    _center_freq[ chan ] = freq;
+    return _routes[chan].dev->post_center_freq( freq, _routes[chan].dev_chan );
+  }
+
+  return ready_future( get_center_freq( chan ) );
+}
+
 double osmosdr_source_c_impl::set_freq_corr( double ppm, size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( osmosdr_src_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        if ( _freq_corr[ chan ] != ppm ) {
-          _freq_corr[ chan ] = ppm;
-          return dev->set_freq_corr( ppm, dev_chan );
-        }
+  boost::recursive_mutex::scoped_lock lock( _mutex );
 
-  return 0;
+  if ( controls( chan ) && _freq_corr[ chan ] != ppm ) {
+    _freq_corr[ chan ] = ppm;
+    return _routes[chan].dev->set_freq_corr( ppm, _routes[chan].dev_chan );
+  }
+
+  return get_freq_corr( chan );
 }
 
 double osmosdr_source_c_impl::get_freq_corr( size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( osmosdr_src_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_freq_corr( dev_chan );
+  if ( chan < _routes.size() )
+    return _routes[chan].dev->get_freq_corr( _routes[chan].dev_chan );
 
   return 0;
 }
 
 std::vector<std::string> osmosdr_source_c_impl::get_gain_names( size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( osmosdr_src_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_gain_names( dev_chan );
+  if ( chan < _routes.size() )
+    return _routes[chan].dev->get_gain_names( _routes[chan].dev_chan );
 
   return std::vector< std::string >();
 }
 
 osmosdr::gain_range_t osmosdr_source_c_impl::get_gain_range( size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( osmosdr_src_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_gain_range( dev_chan );
+  if ( chan < _routes.size() )
+    return _routes[chan].dev->get_gain_range( _routes[chan].dev_chan );
 
   return osmosdr::gain_range_t();
 }
 
 osmosdr::gain_range_t osmosdr_source_c_impl::get_gain_range( const std::string & name, size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( osmosdr_src_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_gain_range( name, dev_chan );
+  if ( chan < _routes.size() )
+    return _routes[chan].dev->get_gain_range( name, _routes[chan].dev_chan );
 
   return osmosdr::gain_range_t();
 }
 
 bool osmosdr_source_c_impl::set_gain_mode( bool automatic, size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( osmosdr_src_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        if ( _gain_mode[ chan ] != automatic ) {
-          _gain_mode[ chan ] = automatic;
-          bool mode = dev->set_gain_mode( automatic, dev_chan );
-          if (!automatic) // reapply gain value when switched to manual mode
-            dev->set_gain( _gain[ chan ], dev_chan );
-          return mode;
-        }
+  boost::recursive_mutex::scoped_lock lock( _mutex );
+
+  if ( controls( chan ) && _gain_mode[ chan ] != automatic ) {
+    _gain_mode[ chan ] = automatic;
+    bool mode = _routes[chan].dev->set_gain_mode( automatic, _routes[chan].dev_chan );
+    if (!automatic) // reapply gain value when switched to manual mode
+      _routes[chan].dev->set_gain( _gain[ chan ], _routes[chan].dev_chan );
+    return mode;
+  }
 
-  return false;
+  return get_gain_mode( chan );
 }
 
 bool osmosdr_source_c_impl::get_gain_mode( size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( osmosdr_src_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_gain_mode( dev_chan );
+  if ( chan < _routes.size() )
+    return _routes[chan].dev->get_gain_mode( _routes[chan].dev_chan );
 
   return false;
 }
 
 double osmosdr_source_c_impl::set_gain( double gain, size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( osmosdr_src_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        if ( _gain[ chan ] != gain ) {
-          _gain[ chan ] = gain;
-          return dev->set_gain( gain, dev_chan );
-        }
+  boost::recursive_mutex::scoped_lock lock( _mutex );
 
-  return 0;
+  if ( controls( chan ) && _gain[ chan ] != gain ) {
+    _gain[ chan ] = gain;
+    return _routes[chan].dev->set_gain( gain, _routes[chan].dev_chan );
+  }
+
+  return get_gain( chan );
+}
+
+osmosdr_future_t osmosdr_source_c_impl::post_gain( double gain, size_t chan )
+{
+  boost::recursive_mutex::scoped_lock lock( _mutex );
+
+  if ( controls( chan ) ) {
+    _gain[ chan ] = gain;
+    return _routes[chan].dev->post_gain( gain, _routes[chan].dev_chan );
+  }
+
+  return ready_future( get_gain( chan ) );
 }
 
 double osmosdr_source_c_impl::set_gain( double gain, const std::string & name, size_t chan)
 {
-  size_t channel = 0;
-  BOOST_FOREACH( osmosdr_src_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->set_gain( gain, name, dev_chan );
+  boost::recursive_mutex::scoped_lock lock( _mutex );
 
-  return 0;
+  if ( controls( chan ) )
+    return _routes[chan].dev->set_gain( gain, name, _routes[chan].dev_chan );
+
+  return get_gain( name, chan );
 }
 
 double osmosdr_source_c_impl::get_gain( size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( osmosdr_src_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_gain( dev_chan );
+  if ( chan < _routes.size() )
+    return _routes[chan].dev->get_gain( _routes[chan].dev_chan );
 
   return 0;
 }
 
 double osmosdr_source_c_impl::get_gain( const std::string & name, size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( osmosdr_src_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_gain( name, dev_chan );
+  if ( chan < _routes.size() )
+    return _routes[chan].dev->get_gain( name, _routes[chan].dev_chan );
 
   return 0;
 }
 
 double osmosdr_source_c_impl::set_if_gain( double gain, size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( osmosdr_src_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        if ( _if_gain[ chan ] != gain ) {
-          _if_gain[ chan ] = gain;
-          return dev->set_if_gain( gain, dev_chan );
-        }
+  boost::recursive_mutex::scoped_lock lock( _mutex );
+
+  if ( controls( chan ) && _if_gain[ chan ] != gain ) {
+    _if_gain[ chan ] = gain;
+    return _routes[chan].dev->set_if_gain( gain, _routes[chan].dev_chan );
+  }
+
+  /* there is no getter, answer for the output controlling the channel */
+  if ( chan < _routes.size() )
+    return _if_gain[ chan - _routes[chan].output ];
 
   return 0;
 }
 
 double osmosdr_source_c_impl::set_bb_gain( double gain, size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( osmosdr_src_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        if ( _bb_gain[ chan ] != gain ) {
-          _bb_gain[ chan ] = gain;
-          return dev->set_bb_gain( gain, dev_chan );
-        }
+  boost::recursive_mutex::scoped_lock lock( _mutex );
+
+  if ( controls( chan ) && _bb_gain[ chan ] != gain ) {
+    _bb_gain[ chan ] = gain;
+    return _routes[chan].dev->set_bb_gain( gain, _routes[chan].dev_chan );
+  }
+
+  if ( chan < _routes.size() )
+    return _bb_gain[ chan - _routes[chan].output ];
 
   return 0;
 }
 
 std::vector< std::string > osmosdr_source_c_impl::get_antennas( size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( osmosdr_src_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_antennas( dev_chan );
+  if ( chan < _routes.size() )
+    return _routes[chan].dev->get_antennas( _routes[chan].dev_chan );
 
   return std::vector< std::string >();
 }
 
 std::string osmosdr_source_c_impl::set_antenna( const std::string & antenna, size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( osmosdr_src_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        if ( _antenna[ chan ] != antenna ) {
-          _antenna[ chan ] = antenna;
-          return dev->set_antenna( antenna, dev_chan );
-        }
+  boost::recursive_mutex::scoped_lock lock( _mutex );
 
-  return "";
+  if ( controls( chan ) && _antenna[ chan ] != antenna ) {
+    _antenna[ chan ] = antenna;
+    return _routes[chan].dev->set_antenna( antenna, _routes[chan].dev_chan );
+  }
+
+  return get_antenna( chan );
 }
 
 std::string osmosdr_source_c_impl::get_antenna( size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( osmosdr_src_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_antenna( dev_chan );
+  if ( chan < _routes.size() )
+    return _routes[chan].dev->get_antenna( _routes[chan].dev_chan );
 
   return "";
 }
 
 void osmosdr_source_c_impl::set_iq_balance_mode( int mode, size_t chan )
 {
+  boost::recursive_mutex::scoped_lock lock( _mutex );
+
 #ifdef HAVE_IQBALANCE
-  size_t channel = 0;
-  BOOST_FOREACH( osmosdr_src_iface *dev, _devs ) {
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++) {
-      if ( chan == channel++ ) {
-        if ( chan < _iq_opt.size() && chan < _iq_fix.size() ) {
-          iqbalance_optimize_c *opt = _iq_opt[chan];
-          iqbalance_fix_cc *fix = _iq_fix[chan];
-
-          if ( IQBalanceOff == mode  ) {
-            opt->set_period( 0 );
-            /* store current values in order to be able to restore them later */
-            _vals[ chan ] = std::pair< float, float >( fix->mag(), fix->phase() );
-            fix->set_mag( 0.0f );
-            fix->set_phase( 0.0f );
-          } else if ( IQBalanceManual == mode ) {
-            if ( opt->period() == 0 ) { /* transition from Off to Manual */
-              /* restore previous values */
-              std::pair< float, float > val = _vals[ chan ];
-              fix->set_mag( val.first );
-              fix->set_phase( val.second );
-            }
-            opt->set_period( 0 );
-          } else if ( IQBalanceAutomatic == mode ) {
-            opt->set_period( dev->get_sample_rate() / 5 );
-            opt->reset();
-          }
-        }
+  if ( controls( chan ) && chan < _iq_opt.size() && chan < _iq_fix.size() ) {
+    iqbalance_optimize_c *opt = _iq_opt[chan];
+
+    if ( IQBalanceOff == mode  ) {
+      opt->set_period( 0 );
+      /* store current values in order to be able to restore them later */
+      _vals[ chan ] = get_iq_correction( chan );
+      set_iq_correction( std::pair< float, float >( 0.0f, 0.0f ), chan );
+    } else if ( IQBalanceManual == mode ) {
+      if ( opt->period() == 0 ) { /* transition from Off to Manual */
+        /* restore previous values */
+        set_iq_correction( _vals[ chan ], chan );
       }
+      opt->set_period( 0 );
+    } else if ( IQBalanceAutomatic == mode ) {
+      opt->set_period( iq_period( chan ) );
+      opt->reset();
     }
   }
 #endif
@@ -659,58 +852,276 @@ void osmosdr_source_c_impl::set_iq_balance_mode( int mode, size_t chan )
 
 void osmosdr_source_c_impl::set_iq_balance( const std::complex<double> &correction, size_t chan )
 {
+  boost::recursive_mutex::scoped_lock lock( _mutex );
+
 #ifdef HAVE_IQBALANCE
-  size_t channel = 0;
-  BOOST_FOREACH( osmosdr_src_iface *dev, _devs ) {
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++) {
-      if ( chan == channel++ ) {
-        if ( chan < _iq_opt.size() && chan < _iq_fix.size() ) {
-          iqbalance_optimize_c *opt = _iq_opt[chan];
-          iqbalance_fix_cc *fix = _iq_fix[chan];
-
-          if ( opt->period() == 0 ) { /* automatic optimization desabled */
-            fix->set_mag( correction.real() );
-            fix->set_phase( correction.imag() );
-          }
-        }
-      }
+  if ( controls( chan ) && chan < _iq_opt.size() && chan < _iq_fix.size() ) {
+    iqbalance_optimize_c *opt = _iq_opt[chan];
+
+    if ( opt->period() == 0 ) { /* automatic optimization desabled */
+      set_iq_correction( std::pair< float, float >( correction.real(),
+                                                    correction.imag() ), chan );
     }
   }
 #endif
 }
 
+void osmosdr_source_c_impl::set_dc_offset_mode( int mode, size_t chan )
+{
+  boost::recursive_mutex::scoped_lock lock( _mutex );
+
+  if ( controls( chan ) )
+    _routes[chan].dev->set_dc_offset_mode( mode, _routes[chan].dev_chan );
+}
+
+void osmosdr_source_c_impl::set_dc_offset( const std::complex<double> &offset, size_t chan )
+{
+  boost::recursive_mutex::scoped_lock lock( _mutex );
+
+  if ( controls( chan ) )
+    _routes[chan].dev->set_dc_offset( offset, _routes[chan].dev_chan );
+}
+
+#ifdef HAVE_IQBALANCE
+double osmosdr_source_c_impl::iq_period( size_t chan )
+{
+  /* an estimate every 200 ms, counted in the samples the optimizer sees */
+  return _routes[chan].dev->get_sample_rate() / 5 / _iq_decim[chan];
+}
+
+std::pair< float, float > osmosdr_source_c_impl::get_iq_correction( size_t chan )
+{
+  if ( _iq_fix[chan] )
+    return std::pair< float, float >( _iq_fix[chan]->mag(), _iq_fix[chan]->phase() );
+
+  std::complex<double> corr = _routes[chan].dev->get_iq_balance( _routes[chan].dev_chan );
+  return std::pair< float, float >( corr.real(), corr.imag() );
+}
+
+void osmosdr_source_c_impl::set_iq_correction( const std::pair< float, float > &val, size_t chan )
+{
+  if ( _iq_fix[chan] ) {
+    _iq_fix[chan]->set_mag( val.first );
+    _iq_fix[chan]->set_phase( val.second );
+  } else {
+    _routes[chan].dev->set_iq_balance( std::complex<double>( val.first, val.second ),
+                                       _routes[chan].dev_chan );
+  }
+}
+#endif
+
 double osmosdr_source_c_impl::set_bandwidth( double bandwidth, size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( osmosdr_src_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        if ( _bandwidth[ chan ] != bandwidth ) {
-          _bandwidth[ chan ] = bandwidth;
-          return dev->set_bandwidth( bandwidth, dev_chan );
-        }
+  boost::recursive_mutex::scoped_lock lock( _mutex );
 
-  return 0;
+  if ( controls( chan ) && _bandwidth[ chan ] != bandwidth ) {
+    _bandwidth[ chan ] = bandwidth;
+    return _routes[chan].dev->set_bandwidth( bandwidth, _routes[chan].dev_chan );
+  }
+
+  return get_bandwidth( chan );
 }
 
 double osmosdr_source_c_impl::get_bandwidth( size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( osmosdr_src_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_bandwidth( dev_chan );
+  if ( chan < _routes.size() )
+    return _routes[chan].dev->get_bandwidth( _routes[chan].dev_chan );
 
   return 0;
 }
 
 osmosdr::freq_range_t osmosdr_source_c_impl::get_bandwidth_range( size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( osmosdr_src_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_bandwidth_range( dev_chan );
+  if ( chan < _routes.size() )
+    return _routes[chan].dev->get_bandwidth_range( _routes[chan].dev_chan );
 
   return osmosdr::freq_range_t();
 }
+
+bool osmosdr_source_c_impl::seek( long seek_point, int whence, size_t chan )
+{
+  boost::recursive_mutex::scoped_lock lock( _mutex );
+
+  if ( controls( chan ) )
+    return _routes[chan].dev->seek( seek_point, whence, _routes[chan].dev_chan );
+
+  return false;
+}
+
+bool osmosdr_source_c_impl::set_sweep( const std::vector< double > &freqs,
+                                       double dwell, double settle,
+                                       bool tag_hops, size_t chan )
+{
+  boost::recursive_mutex::scoped_lock lock( _mutex );
+
+  if ( controls( chan ) ) {
+    /* the device tunes by itself from now on */
+    _center_freq.erase( chan );
+
+    return _routes[chan].dev->set_sweep( freqs, dwell, settle, tag_hops,
+                                         _routes[chan].dev_chan );
+  }
+
+  return false;
+}
+
+std::vector< double > osmosdr_source_c_impl::set_center_freqs( const std::vector< double > &freqs )
+{
+  boost::recursive_mutex::scoped_lock lock( _mutex );
+
+  std::vector< double > actual = \
+      set_channels( freqs, _center_freq,
+                    &osmosdr_src_iface::set_center_freq, &osmosdr_src_iface::get_center_freq );
+
+  /* the devices report their own center, not the one of a channelizer output */
+  for (size_t chan = 0; chan < actual.size(); chan++)
+    actual[ chan ] += freq_offset( chan );
+
+  return actual;
+}
+
+std::vector< double > osmosdr_source_c_impl::set_gains( const std::vector< double > &gains )
+{
+  boost::recursive_mutex::scoped_lock lock( _mutex );
+
+  return set_channels( gains, _gain,
+                       &osmosdr_src_iface::set_gain, &osmosdr_src_iface::get_gain );
+}
+
+std::vector< double > osmosdr_source_c_impl::set_bandwidths( const std::vector< double > &bandwidths )
+{
+  boost::recursive_mutex::scoped_lock lock( _mutex );
+
+  return set_channels( bandwidths, _bandwidth,
+                       &osmosdr_src_iface::set_bandwidth, &osmosdr_src_iface::get_bandwidth );
+}
+
+void osmosdr_source_c_impl::apply_batch( device_batch_t &batch )
+{
+  for (size_t i = 0; i < batch.dev_chans.size(); i++)
+    batch.actual[i] = (batch.dev->*batch.setter)( batch.values[i], batch.dev_chans[i] );
+}
+
+std::vector< double > osmosdr_source_c_impl::set_channels( const std::vector< double > &values,
+                                                   std::map< size_t, double > &cache,
+                                                   channel_setter_t setter,
+                                                   channel_getter_t getter )
+{
+  size_t count = std::min( values.size(), _routes.size() );
+  std::vector< double > actual( count );
+  std::vector< bool > changed( count, false );
+
+  std::vector< device_batch_t > batches;
+  std::map< osmosdr_src_iface *, size_t > batch_of;
+
+  for (size_t chan = 0; chan < count; chan++) {
+    if ( ! controls( chan ) )
+      continue;
+
+    if ( cache.count( chan ) && cache[ chan ] == values[ chan ] )
+      continue;
+
+    cache[ chan ] = values[ chan ];
+    changed[ chan ] = true;
+
+    const route_t &route = _routes[chan];
+
+    if ( ! batch_of.count( route.dev ) ) {
+      batch_of[ route.dev ] = batches.size();
+      device_batch_t batch;
+      batch.dev = route.dev;
+      batch.setter = setter;
+      batches.push_back( batch );
+    }
+
+    device_batch_t &batch = batches[ batch_of[ route.dev ] ];
+    batch.chans.push_back( chan );
+    batch.dev_chans.push_back( route.dev_chan );
+    batch.values.push_back( values[ chan ] );
+    batch.actual.push_back( 0 );
+  }
+
+  /* all devices at once, so they change over at about the same time */
+  std::vector< parallel_job_t > jobs;
+  for (size_t i = 0; i < batches.size(); i++)
+    jobs.push_back( boost::bind( &osmosdr_source_c_impl::apply_batch, boost::ref( batches[i] ) ) );
+
+  std::vector< std::string > errors = run_parallel( jobs, jobs.size() );
+
+  for (size_t i = 0; i < batches.size(); i++) {
+    for (size_t j = 0; j < batches[i].chans.size(); j++) {
+      if ( errors[i].length() )
+        cache.erase( batches[i].chans[j] ); /* unknown state, don't skip next time */
+      else
+        actual[ batches[i].chans[j] ] = batches[i].actual[j];
+    }
+  }
+
+  throw_first_error( errors );
+
+  for (size_t chan = 0; chan < count; chan++)
+    if ( ! changed[ chan ] )
+      actual[ chan ] = (_routes[chan].dev->*getter)( _routes[chan].dev_chan );
+
+  return actual;
+}
+
+pmt::pmt_t osmosdr_source_c_impl::apply_command( pmt::pmt_t cmd )
+{
+  /* the whole command at once, in between the calls of other threads */
+  boost::recursive_mutex::scoped_lock lock( _mutex );
+
+  if ( ! pmt::pmt_is_dict( cmd ) )
+    throw std::runtime_error( "Commands are expected to be PMT dicts." );
+
+  pmt::pmt_t status = pmt::pmt_make_dict();
+  double chan = 0, value;
+  std::string antenna;
+
+  try {
+    command_get( cmd, "chan", chan );
+    status = pmt::pmt_dict_add( status, pmt::pmt_intern( "chan" ),
+                                pmt::pmt_from_long( long(chan) ) );
+
+    /* the rate goes first, it may change the bandwidth */
+    if ( command_get( cmd, "rate", value ) ) {
+      set_sample_rate( value );
+      status = pmt::pmt_dict_add( status, pmt::pmt_intern( "rate" ),
+                                  pmt::pmt_from_double( get_sample_rate() ) );
+    }
+
+    if ( command_get( cmd, "freq", value ) ) {
+      set_center_freq( value, size_t(chan) );
+      status = pmt::pmt_dict_add( status, pmt::pmt_intern( "freq" ),
+                                  pmt::pmt_from_double( get_center_freq( size_t(chan) ) ) );
+    }
+
+    if ( command_get( cmd, "gain", value ) ) {
+      set_gain( value, size_t(chan) );
+      status = pmt::pmt_dict_add( status, pmt::pmt_intern( "gain" ),
+                                  pmt::pmt_from_double( get_gain( size_t(chan) ) ) );
+    }
+
+    if ( command_get( cmd, "bandwidth", value ) ) {
+      set_bandwidth( value, size_t(chan) );
+      status = pmt::pmt_dict_add( status, pmt::pmt_intern( "bandwidth" ),
+                                  pmt::pmt_from_double( get_bandwidth( size_t(chan) ) ) );
+    }
+
+    if ( command_get( cmd, "antenna", antenna ) ) {
+      set_antenna( antenna, size_t(chan) );
+      status = pmt::pmt_dict_add( status, pmt::pmt_intern( "antenna" ),
+                                  pmt::pmt_intern( get_antenna( size_t(chan) ) ) );
+    }
+  } catch ( std::exception &ex ) {
+    status = pmt::pmt_dict_add( status, pmt::pmt_intern( "error" ),
+                                pmt::pmt_intern( ex.what() ) );
+  }
+
+  return status;
+}
+
+gr_basic_block_sptr osmosdr_source_c_impl::control_block()
+{
+  return _control;
+}
@@ -28,9 +28,12 @@
 #endif
 
 #include <osmosdr_src_iface.h>
+#include <osmosdr_control.h>
 
 #include <map>
 
+#include <boost/thread/recursive_mutex.hpp>
+
 class osmosdr_source_c_impl : public osmosdr_source_c
 {
 public:
@@ -43,6 +46,7 @@ public:
   osmosdr::freq_range_t get_freq_range( size_t chan = 0 );
   double set_center_freq( double freq, size_t chan = 0 );
   double get_center_freq( size_t chan = 0 );
+  osmosdr_future_t post_center_freq( double freq, size_t chan = 0 );
   double set_freq_corr( double ppm, size_t chan = 0 );
   double get_freq_corr( size_t chan = 0 );
 
@@ -52,6 +56,7 @@ public:
   bool set_gain_mode( bool automatic, size_t chan = 0 );
   bool get_gain_mode( size_t chan = 0 );
   double set_gain( double gain, size_t chan = 0 );
+  osmosdr_future_t post_gain( double gain, size_t chan = 0 );
   double set_gain( double gain, const std::string & name, size_t chan = 0 );
   double get_gain( size_t chan = 0 );
   double get_gain( const std::string & name, size_t chan = 0 );
@@ -66,10 +71,25 @@ public:
   void set_iq_balance_mode( int mode, size_t chan = 0 );
   void set_iq_balance( const std::complex<double> &correction, size_t chan = 0 );
 
+  void set_dc_offset_mode( int mode, size_t chan = 0 );
+  void set_dc_offset( const std::complex<double> &offset, size_t chan = 0 );
+
   double set_bandwidth( double bandwidth, size_t chan = 0 );
   double get_bandwidth( size_t chan = 0 );
   osmosdr::freq_range_t get_bandwidth_range( size_t chan = 0 );
 
+  bool seek( long seek_point, int whence, size_t chan = 0 );
+
+  std::vector< double > set_center_freqs( const std::vector< double > &freqs );
+  std::vector< double > set_gains( const std::vector< double > &gains );
+  std::vector< double > set_bandwidths( const std::vector< double > &bandwidths );
+
+  bool set_sweep( const std::vector< double > &freqs,
+                  double dwell, double settle,
+                  bool tag_hops = true, size_t chan = 0 );
+
+  gr_basic_block_sptr control_block( void );
+
 private:
   osmosdr_source_c_impl (const std::string & args);  	// private constructor
 
@@ -79,6 +99,40 @@ private:
 
   std::vector< osmosdr_src_iface * > _devs;
 
+  /* maps a channel of the group to the device serving it */
+  struct route_t {
+    osmosdr_src_iface *dev;
+    size_t dev_chan;
+    size_t output;  /* index among the outputs of a channelizer, 0 without */
+    size_t outputs; /* number of channelizer outputs, 1 without */
+  };
+  std::vector< route_t > _routes;
+
+  size_t connect_band( gr_basic_block_sptr band, int port, size_t pfb_chans, size_t first );
+  bool controls( size_t chan );
+  double freq_offset( size_t chan );
+
+  typedef double (osmosdr_src_iface::*channel_setter_t)( double, size_t );
+  typedef double (osmosdr_src_iface::*channel_getter_t)( size_t );
+
+  /* the changed channels of one device, set in order on a pool thread */
+  struct device_batch_t {
+    osmosdr_src_iface *dev;
+    channel_setter_t setter;
+    std::vector< size_t > chans;
+    std::vector< size_t > dev_chans;
+    std::vector< double > values;
+    std::vector< double > actual;
+  };
+
+  static void apply_batch( device_batch_t &batch );
+  static void apply_sample_rate( osmosdr_src_iface *dev, double rate, double &actual );
+
+  std::vector< double > set_channels( const std::vector< double > &values,
+                                      std::map< size_t, double > &cache,
+                                      channel_setter_t setter,
+                                      channel_getter_t getter );
+
   double _sample_rate;
   std::map< size_t, double > _center_freq;
   std::map< size_t, double > _freq_corr;
@@ -88,11 +142,23 @@ private:
   std::map< size_t, double > _bb_gain;
   std::map< size_t, std::string > _antenna;
 #ifdef HAVE_IQBALANCE
-  std::vector< iqbalance_fix_cc * > _iq_fix;
+  std::vector< iqbalance_fix_cc * > _iq_fix; /* NULL where the device corrects */
   std::vector< iqbalance_optimize_c * > _iq_opt;
+  std::vector< size_t > _iq_decim;
   std::map< size_t, std::pair<float, float> > _vals;
+
+  double iq_period( size_t chan );
+  std::pair< float, float > get_iq_correction( size_t chan );
+  void set_iq_correction( const std::pair< float, float > &val, size_t chan );
 #endif
   std::map< size_t, double > _bandwidth;
+
+  /* serializes the setters, called from user threads and from _control */
+  boost::recursive_mutex _mutex;
+
+  pmt::pmt_t apply_command( pmt::pmt_t cmd );
+
+  osmosdr_control_sptr _control;
 };
 
 #endif /* INCLUDED_OSMOSDR_SOURCE_C_IMPL_H */
@@ -24,6 +24,8 @@
 #include <osmosdr/osmosdr_ranges.h>
 #include <gr_basic_block.h>
 
+#include "osmosdr_setter_queue.h"
+
 class osmosdr_src_iface;
 
 typedef boost::shared_ptr<osmosdr_src_iface> osmosdr_src_iface_sptr;
@@ -85,6 +87,21 @@ public:
    */
   virtual double get_center_freq( size_t chan = 0 ) = 0;
 
+  /*!
+   * Tune without waiting for the hardware.
+   * Devices with a control thread replace a setting which hasn't been
+   * applied yet by the latest one, others apply it right away.
+   * \param freq the desired frequency in Hz
+   * \param chan the channel index 0 to N-1
+   * \return a future for the actual frequency in Hz
+   */
+  virtual osmosdr_future_t post_center_freq( double freq, size_t chan = 0 )
+  {
+    boost::promise< double > promise;
+    promise.set_value( set_center_freq( freq, chan ) );
+    return osmosdr_future_t( promise.get_future() );
+  }
+
   /*!
    * Set the frequency correction value in parts per million.
    * \param ppm the desired correction value in parts per million
@@ -149,6 +166,20 @@ public:
    */
   virtual double set_gain( double gain, size_t chan = 0 ) = 0;
 
+  /*!
+   * Set the overall gain without waiting for the hardware.
+   * See post_center_freq() for how pending settings are treated.
+   * \param gain the gain in dB
+   * \param chan the channel index 0 to N-1
+   * \return a future for the actual gain in dB
+   */
+  virtual osmosdr_future_t post_gain( double gain, size_t chan = 0 )
+  {
+    boost::promise< double > promise;
+    promise.set_value( set_gain( gain, chan ) );
+    return osmosdr_future_t( promise.get_future() );
+  }
+
   /*!
    * Set the named gain on the underlying radio hardware.
    * \param gain the gain in dB
@@ -234,6 +265,40 @@ public:
    */
   virtual void set_iq_balance( const std::complex<double> &correction, size_t chan = 0 ) { }
 
+  /*!
+   * Tell whether the device applies the IQ balance correction itself while
+   * converting the samples. It then takes set_iq_balance() as well as the
+   * estimates of a iqbalance_optimize_c on its "iqbal_corr" message port,
+   * and no iqbalance_fix_cc is needed behind it.
+   *
+   * \return true if the correction is done by the device
+   */
+  virtual bool fused_iq_balance( void ) { return false; }
+
+  /*!
+   * Get the IQ balance correction applied by the device.
+   *
+   * \param chan the channel index 0 to N-1
+   * \return the complex correction value
+   */
+  virtual std::complex<double> get_iq_balance( size_t chan = 0 ) { return 0; }
+
+  /*!
+   * Set the RX frontend DC offset correction mode.
+   *
+   * \param mode dc offset correction mode: 0 = Off, 1 = Manual, 2 = Automatic
+   * \param chan the channel index 0 to N-1
+   */
+  virtual void set_dc_offset_mode( int mode, size_t chan = 0 ) { }
+
+  /*!
+   * Set the RX frontend DC offset correction.
+   *
+   * \param offset the complex offset, in units of full scale
+   * \param chan the channel index 0 to N-1
+   */
+  virtual void set_dc_offset( const std::complex<double> &offset, size_t chan = 0 ) { }
+
   /*!
    * Set the bandpass filter on the radio frontend.
    * \param bandwidth the filter bandwidth in Hz
@@ -256,6 +321,28 @@ public:
    */
   virtual osmosdr::freq_range_t get_bandwidth_range( size_t chan = 0 )
     { return osmosdr::freq_range_t(); }
+
+  /*!
+   * Reposition a seekable source, like a recording being played back.
+   * \param seek_point the position in samples
+   * \param whence SEEK_SET, SEEK_CUR or SEEK_END as with fseek
+   * \param chan the channel index 0 to N-1
+   * \return true on success
+   */
+  virtual bool seek( long seek_point, int whence, size_t chan = 0 ) { return false; }
+
+  /*!
+   * Step the tuner through a list of frequencies.
+   * \param freqs the frequencies in Hz, an empty list stops sweeping
+   * \param dwell the seconds of samples to deliver per frequency
+   * \param settle the seconds of samples to drop after every retune
+   * \param tag_hops tag the first sample of every hop with its index
+   * \param chan the channel index 0 to N-1
+   * \return false if the hardware doesn't support sweeping
+   */
+  virtual bool set_sweep( const std::vector< double > &freqs,
+                          double dwell, double settle,
+                          bool tag_hops = true, size_t chan = 0 ) { return false; }
 };
 
 #endif // OSMOSDR_SRC_IFACE_H
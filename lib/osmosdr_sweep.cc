@@ -0,0 +1,161 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2013 Dimitri Stolnikov <horiz0n@gmx.net>
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <iostream>
+#include <stdexcept>
+
+#include <boost/bind.hpp>
+
+#include "osmosdr_sweep.h"
+
+osmosdr_sweep::osmosdr_sweep( tune_fn_t tune )
+  : _tune(tune),
+    _hop_samples(0),
+    _settle(0),
+    _index(0),
+    _count(0),
+    _tune_pending(false),
+    _generation(0),
+    _running(true)
+{
+}
+
+osmosdr_sweep::~osmosdr_sweep()
+{
+  stop();
+}
+
+void osmosdr_sweep::stop()
+{
+  {
+    boost::mutex::scoped_lock lock( _mutex );
+    _running = false;
+    _freqs.clear();
+  }
+
+  _cond.notify_all();
+
+  if ( _thread.joinable() )
+    _thread.join();
+}
+
+void osmosdr_sweep::start( const std::vector< double > &freqs,
+                           size_t hop_samples, double settle )
+{
+  {
+    boost::mutex::scoped_lock lock( _mutex );
+
+    _freqs = freqs;
+    _hop_samples = hop_samples;
+    _settle = settle;
+    _index = 0;
+    _count = 0;
+    _generation++;
+
+    if ( _freqs.empty() )
+      return;
+
+    _tune_pending = true;
+
+    if ( ! _thread.joinable() )
+      _thread = gruel::thread( boost::bind( &osmosdr_sweep::sweeper, this ) );
+  }
+
+  _cond.notify_all();
+}
+
+bool osmosdr_sweep::active()
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  return ! _freqs.empty();
+}
+
+double osmosdr_sweep::settle()
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  return _freqs.empty() ? -1 : _settle;
+}
+
+bool osmosdr_sweep::filled( size_t samples )
+{
+  bool retune = false;
+
+  {
+    boost::mutex::scoped_lock lock( _mutex );
+
+    if ( _freqs.empty() )
+      return true;
+
+    /* captured while the tuner was moving */
+    if ( _tune_pending )
+      return false;
+
+    _count += samples;
+
+    if ( _count >= _hop_samples ) {
+      _index = (_index + 1) % _freqs.size();
+      _count = 0;
+      _tune_pending = retune = true;
+    }
+  }
+
+  if ( retune )
+    _cond.notify_all();
+
+  return true;
+}
+
+void osmosdr_sweep::sweeper()
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  while ( _running ) {
+    if ( ! _tune_pending || _freqs.empty() ) {
+      _tune_pending = false;
+      _cond.wait( lock );
+      continue;
+    }
+
+    size_t index = _index;
+    double freq = _freqs[ index ];
+    unsigned int generation = _generation;
+
+    lock.unlock();
+
+    try {
+      _tune( index, freq );
+    } catch ( std::exception &ex ) {
+      std::cerr << "Sweep failed to tune to " << freq << " Hz: "
+                << ex.what() << std::endl;
+    }
+
+    lock.lock();
+
+    /* a restart while we were tuning asks for another round */
+    if ( _generation == generation )
+      _tune_pending = false;
+  }
+}
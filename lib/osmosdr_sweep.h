@@ -0,0 +1,89 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2013 Dimitri Stolnikov <horiz0n@gmx.net>
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_SWEEP_H
+#define OSMOSDR_SWEEP_H
+
+#include <vector>
+
+#include <boost/function.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <gruel/thread.h>
+
+/*!
+ * Steps a hardware source through a list of frequencies.
+ *
+ * The device callback reports every transfer through filled(). Once a hop
+ * has collected enough samples, the retune is handed to a thread of its own,
+ * so the callback never waits for the tuner. Transfers arriving while the
+ * tuner is busy are dropped, hence every hop starts at a transfer boundary
+ * and the next transfer is the first one captured at the new frequency.
+ *
+ * The tune function is expected to report the change to the change marks
+ * of the source, which tag the first sample of the hop and drop the
+ * settling period in front of it.
+ */
+class osmosdr_sweep
+{
+public:
+  /* hop index and frequency to tune to, runs on the sweep thread */
+  typedef boost::function< void ( size_t, double ) > tune_fn_t;
+
+  osmosdr_sweep( tune_fn_t tune );
+  ~osmosdr_sweep();
+
+  /*!
+   * Starts sweeping over freqs, an empty list stops.
+   * \param hop_samples samples to capture per hop, the settling period included
+   * \param settle seconds to drop at the start of every hop
+   */
+  void start( const std::vector< double > &freqs, size_t hop_samples, double settle );
+
+  /* stops sweeping and waits for a retune in progress, before the device goes away */
+  void stop();
+
+  bool active();
+
+  /* seconds to drop after a retune, or -1 if not sweeping */
+  double settle();
+
+  /* device thread: returns false if the transfer is to be dropped */
+  bool filled( size_t samples );
+
+private:
+  void sweeper();
+
+  tune_fn_t _tune;
+
+  std::vector< double > _freqs;
+  size_t _hop_samples;
+  double _settle;
+  size_t _index;        /* hop being captured */
+  size_t _count;        /* samples captured for it so far */
+  bool _tune_pending;
+  unsigned int _generation; /* counts start() calls */
+  bool _running;
+
+  boost::mutex _mutex;
+  boost::condition_variable _cond;
+  gruel::thread _thread;
+};
+
+#endif // OSMOSDR_SWEEP_H
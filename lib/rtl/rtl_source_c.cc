@@ -29,19 +29,23 @@
 
 #include "rtl_source_c.h"
 #include <gr_io_signature.h>
+#include <gruel/pmt.h>
 
 #include <boost/assign.hpp>
 #include <boost/format.hpp>
 #include <boost/detail/endian.hpp>
 #include <boost/algorithm/string.hpp>
+#include <boost/bind.hpp>
 
 #include <stdexcept>
+#include <algorithm>
 #include <iostream>
 #include <stdio.h>
 
 #include <rtl-sdr.h>
 
 #include <osmosdr_arg_helpers.h>
+#include <osmosdr_recorder.h>
 
 using namespace boost::assign;
 
@@ -56,9 +60,9 @@ using namespace boost::assign;
  * a boost shared_ptr.  This is effectively the public constructor.
  */
 rtl_source_c_sptr
-make_rtl_source_c (const std::string &args)
+make_rtl_source_c (const std::string &args, rtlsdr_dev_t *dev)
 {
-  return gnuradio::get_initial_sptr(new rtl_source_c (args));
+  return gnuradio::get_initial_sptr(new rtl_source_c (args, dev));
 }
 
 /*
@@ -78,22 +82,121 @@ static const int MAX_OUT = 1;	// maximum number of output streams
 /*
  * The private constructor
  */
-rtl_source_c::rtl_source_c (const std::string &args)
+rtl_source_c::rtl_source_c (const std::string &args, rtlsdr_dev_t *dev)
   : gr_sync_block ("rtl_source_c",
         gr_make_io_signature (MIN_IN, MAX_IN, sizeof (gr_complex)),
         gr_make_io_signature (MIN_OUT, MAX_OUT, sizeof (gr_complex))),
-    _dev(NULL),
+    _dev(dev),
     _buf(NULL),
     _running(true),
     _no_tuner(false),
     _auto_gain(false),
     _if_gain(0),
-    _skipped(0)
+    _skipped(0),
+    _sample_rate(0),
+    _center_freq(0),
+    _freq_corr(0),
+    _gain(0),
+    _settle(0),
+    _discard(0),
+    _tag_hops(false),
+    _sweep( boost::bind( &rtl_source_c::sweep_tune, this, _1, _2 ) )
+{
+  unsigned int direct_samp = 0;
+
+  dict_t dict = params_to_dict(args);
+
+  if (dict.count("direct_samp"))
+    direct_samp = boost::lexical_cast< unsigned int >( dict["direct_samp"] );
+
+  _buf_num = _buf_len = _buf_head = _buf_used = _buf_offset = 0;
+
+  if (dict.count("buffers"))
+    _buf_num = boost::lexical_cast< unsigned int >( dict["buffers"] );
+
+  if (dict.count("buflen"))
+    _buf_len = boost::lexical_cast< unsigned int >( dict["buflen"] );
+
+  if (0 == _buf_num)
+    _buf_num = BUF_NUM;
+
+  if (0 == _buf_len || _buf_len % 512 != 0) /* len must be multiple of 512 */
+    _buf_len = BUF_LEN;
+
+  if ( BUF_NUM != _buf_num || BUF_LEN != _buf_len ) {
+    std::cerr << "Using " << _buf_num << " buffers of size " << _buf_len << "."
+              << std::endl;
+  }
+
+  _samp_avail = _buf_len / BYTES_PER_SAMPLE;
+
+  if (dict.count("settle"))
+    _settle = boost::lexical_cast< double >( dict["settle"] );
+
+  if (dict.count("ddc")) {
+    double offset = 0;
+    if (dict.count("ddc_offset"))
+      offset = boost::lexical_cast< double >( dict["ddc_offset"] );
+
+    _ddc.configure( boost::lexical_cast< size_t >( dict["ddc"] ), offset );
+  }
+
+  _marks.resize( _buf_num );
+
+  // create a lookup table for gr_complex values
+  _corr.build_cu8_lut( _lut );
+  _corr.changed();
+
+  /* takes the estimates of a iqbalance_optimize_c directly */
+  message_port_register_in( pmt::pmt_intern( "iqbal_corr" ) );
+  set_msg_handler( pmt::pmt_intern( "iqbal_corr" ),
+                   boost::bind( &osmosdr_correction::iqbal_corr, &_corr, _1 ) );
+
+  /* opened ahead by the caller or right here, the tuner is in manual gain mode */
+  if (!_dev)
+    _dev = open_device( args );
+  _no_tuner = direct_samp != 0;
+
+  /* the control thread clips against these while others copy them */
+  _freq_range = query_freq_range();
+  _gain_range = query_gain_range();
+  if ( ! _freq_range.empty() )
+    _freq_range.update();
+  if ( ! _gain_range.empty() )
+    _gain_range.update();
+
+  _sample_rate = (double)rtlsdr_get_sample_rate( _dev );
+  _ddc.set_sample_rate( _sample_rate );
+  _center_freq = (double)rtlsdr_get_center_freq( _dev );
+  _freq_corr = (double)rtlsdr_get_freq_correction( _dev );
+  _gain = ((double)rtlsdr_get_tuner_gain( _dev )) / 10.0;
+
+  set_if_gain( 24 ); /* preset to a reasonable default (non-GRC use case) */
+
+  _buf = (unsigned short **) malloc(_buf_num * sizeof(unsigned short *));
+
+  if (_buf) {
+    for(unsigned int i = 0; i < _buf_num; ++i)
+      _buf[i] = (unsigned short *) malloc(_buf_len);
+  }
+
+  _recorder = make_recorder_from_args( dict, "cu8" );
+
+  _thread = gruel::thread(_rtlsdr_wait, this);
+}
+
+/*
+ * Our virtual destructor.
+ */
+/* finds and opens the device the arguments ask for and sets it up, which
+ * takes a while. Runs concurrently for the devices of a group. */
+rtlsdr_dev_t *rtl_source_c::open_device( const std::string &args )
 {
   int ret;
   int index;
   unsigned int dev_index = 0, rtl_freq = 0, tuner_freq = 0, direct_samp = 0;
   unsigned int offset_tune = 0;
+  rtlsdr_dev_t *dev = NULL;
   char manufact[256];
   char product[256];
   char serial[256];
@@ -146,101 +249,69 @@ rtl_source_c::rtl_source_c (const std::string &args)
   if (dict.count("offset_tune"))
     offset_tune = boost::lexical_cast< unsigned int >( dict["offset_tune"] );
 
-  _buf_num = _buf_len = _buf_head = _buf_used = _buf_offset = 0;
-
-  if (dict.count("buffers"))
-    _buf_num = boost::lexical_cast< unsigned int >( dict["buffers"] );
-
-  if (dict.count("buflen"))
-    _buf_len = boost::lexical_cast< unsigned int >( dict["buflen"] );
-
-  if (0 == _buf_num)
-    _buf_num = BUF_NUM;
-
-  if (0 == _buf_len || _buf_len % 512 != 0) /* len must be multiple of 512 */
-    _buf_len = BUF_LEN;
-
-  if ( BUF_NUM != _buf_num || BUF_LEN != _buf_len ) {
-    std::cerr << "Using " << _buf_num << " buffers of size " << _buf_len << "."
-              << std::endl;
-  }
-
-  _samp_avail = _buf_len / BYTES_PER_SAMPLE;
-
-  // create a lookup table for gr_complex values
-  for (unsigned int i = 0; i <= 0xffff; i++) {
-#ifdef BOOST_LITTLE_ENDIAN
-    _lut.push_back( gr_complex( (float(i & 0xff) - 127.5f) * (1.0f/128.0f),
-                                (float(i >> 8) - 127.5f) * (1.0f/128.0f) ) );
-#else // BOOST_BIG_ENDIAN
-    _lut.push_back( gr_complex( (float(i >> 8) - 127.5f) * (1.0f/128.0f),
-                                (float(i & 0xff) - 127.5f) * (1.0f/128.0f) ) );
-#endif
-  }
-
-  _dev = NULL;
-  ret = rtlsdr_open( &_dev, dev_index );
+  ret = rtlsdr_open( &dev, dev_index );
   if (ret < 0)
     throw std::runtime_error("Failed to open rtlsdr device.");
 
-  if (rtl_freq > 0 || tuner_freq > 0) {
-    if (rtl_freq)
-      std::cerr << "Setting rtl clock to " << rtl_freq << " Hz." << std::endl;
-    if (tuner_freq)
-      std::cerr << "Setting tuner clock to " << tuner_freq << " Hz." << std::endl;
-
-    ret = rtlsdr_set_xtal_freq( _dev, rtl_freq, tuner_freq );
-    if (ret < 0)
-      throw std::runtime_error(
-        str(boost::format("Failed to set xtal frequencies. Error %d.") % ret ));
-  }
-
-  ret = rtlsdr_set_sample_rate( _dev, 1024000 );
-  if (ret < 0)
-    throw std::runtime_error("Failed to set default samplerate.");
-
-  ret = rtlsdr_set_tuner_gain_mode(_dev, int(!_auto_gain));
-  if (ret < 0)
-    throw std::runtime_error("Failed to set tuner gain mode.");
+  try {
+    if (rtl_freq > 0 || tuner_freq > 0) {
+      if (rtl_freq)
+        std::cerr << "Setting rtl clock to " << rtl_freq << " Hz." << std::endl;
+      if (tuner_freq)
+        std::cerr << "Setting tuner clock to " << tuner_freq << " Hz." << std::endl;
 
-  ret = rtlsdr_set_agc_mode(_dev, int(_auto_gain));
-  if (ret < 0)
-    throw std::runtime_error("Failed to set agc mode.");
+      ret = rtlsdr_set_xtal_freq( dev, rtl_freq, tuner_freq );
+      if (ret < 0)
+        throw std::runtime_error(
+          str(boost::format("Failed to set xtal frequencies. Error %d.") % ret ));
+    }
 
-  if (direct_samp) {
-    ret = rtlsdr_set_direct_sampling(_dev, direct_samp);
+    ret = rtlsdr_set_sample_rate( dev, 1024000 );
     if (ret < 0)
-      throw std::runtime_error("Failed to enable direct sampling.");
-    _no_tuner = true;
-  }
+      throw std::runtime_error("Failed to set default samplerate.");
 
-  if (offset_tune) {
-    ret = rtlsdr_set_offset_tuning(_dev, offset_tune);
+    ret = rtlsdr_set_tuner_gain_mode(dev, 1); /* manual, like _auto_gain */
     if (ret < 0)
-      throw std::runtime_error("Failed to enable offset tuning.");
-  }
+      throw std::runtime_error("Failed to set tuner gain mode.");
 
-  ret = rtlsdr_reset_buffer( _dev );
-  if (ret < 0)
-    throw std::runtime_error("Failed to reset usb buffers.");
+    ret = rtlsdr_set_agc_mode(dev, 0);
+    if (ret < 0)
+      throw std::runtime_error("Failed to set agc mode.");
 
-  set_if_gain( 24 ); /* preset to a reasonable default (non-GRC use case) */
+    if (direct_samp) {
+      ret = rtlsdr_set_direct_sampling(dev, direct_samp);
+      if (ret < 0)
+        throw std::runtime_error("Failed to enable direct sampling.");
+    }
 
-  _buf = (unsigned short **) malloc(_buf_num * sizeof(unsigned short *));
+    if (offset_tune) {
+      ret = rtlsdr_set_offset_tuning(dev, offset_tune);
+      if (ret < 0)
+        throw std::runtime_error("Failed to enable offset tuning.");
+    }
 
-  if (_buf) {
-    for(unsigned int i = 0; i < _buf_num; ++i)
-      _buf[i] = (unsigned short *) malloc(_buf_len);
+    ret = rtlsdr_reset_buffer( dev );
+    if (ret < 0)
+      throw std::runtime_error("Failed to reset usb buffers.");
+  } catch ( ... ) {
+    rtlsdr_close( dev );
+    throw;
   }
 
-  _thread = gruel::thread(_rtlsdr_wait, this);
+  return dev;
+}
+
+void rtl_source_c::close_device( rtlsdr_dev_t *dev )
+{
+  rtlsdr_close( dev );
 }
 
-/*
- * Our virtual destructor.
- */
 rtl_source_c::~rtl_source_c ()
 {
+  /* the sweep tunes through the setters, which must be done with the device */
+  _sweep.stop();
+  _setters.stop();
+
   if (_dev) {
     _running = false;
     rtlsdr_cancel_async( _dev );
@@ -273,6 +344,12 @@ void rtl_source_c::rtlsdr_callback(unsigned char *buf, uint32_t len)
     return;
   }
 
+  if (!_sweep.filled( len / BYTES_PER_SAMPLE ))
+    return; /* captured while retuning */
+
+  if (_recorder)
+    _recorder->write(buf, len);
+
   {
     boost::mutex::scoped_lock lock( _buf_mutex );
 
@@ -281,10 +358,14 @@ void rtl_source_c::rtlsdr_callback(unsigned char *buf, uint32_t len)
 
     if (_buf_used == _buf_num) {
       std::cerr << "O" << std::flush;
+      _marks.drop( _buf_head, (_buf_head + 1) % _buf_num );
       _buf_head = (_buf_head + 1) % _buf_num;
     } else {
       _buf_used++;
     }
+
+    /* everything queued before was captured with the old settings */
+    _marks.mark( buf_tail );
   }
 
   _buf_cond.notify_one();
@@ -323,37 +404,86 @@ int rtl_source_c::work( int noutput_items,
   if (!_running)
     return WORK_DONE;
 
-  unsigned short *buf = _buf[_buf_head] + _buf_offset;
-
-  if (noutput_items <= _samp_avail) {
-    for (int i = 0; i < noutput_items; ++i)
-      *out++ = _lut[ *(buf + i) ];
+  /* new correction values are folded into the table, nothing to do per sample */
+  if ( _corr.changed() )
+    _corr.build_cu8_lut( _lut );
 
-    _buf_offset += noutput_items;
-    _samp_avail -= noutput_items;
-  } else {
-    for (int i = 0; i < _samp_avail; ++i)
-      *out++ = _lut[ *(buf + i) ];
+  int produced = 0;
 
-    {
+  while (produced < noutput_items) {
+    if (0 == _samp_avail) {
       boost::mutex::scoped_lock lock( _buf_mutex );
 
       _buf_head = (_buf_head + 1) % _buf_num;
       _buf_used--;
+
+      _buf_offset = 0;
+      _samp_avail = _buf_len / BYTES_PER_SAMPLE;
+
+      if (0 == _buf_used)
+        break;
     }
 
-    buf = _buf[_buf_head];
+    if (0 == _buf_offset)
+      _corr.estimate_cu8( (unsigned char *)(_buf[_buf_head]), _samp_avail );
 
-    int remaining = noutput_items - _samp_avail;
+    osmosdr_change_marks::changes_t changes;
+    if (0 == _buf_offset && _marks.take( _buf_head, changes )) {
+      for (osmosdr_change_marks::changes_t::iterator it = changes.begin();
+           it != changes.end(); ++it)
+        _changes[ it->first ] = it->second;
 
-    for (int i = 0; i < remaining; ++i)
-      *out++ = _lut[ *(buf + i) ];
+      double settle = _sweep.settle();
+      if (settle < 0)
+        settle = _settle;
 
-    _buf_offset = remaining;
-    _samp_avail = (_buf_len / BYTES_PER_SAMPLE) - remaining;
+      _discard = size_t(settle * _sample_rate); /* device samples */
+    }
+
+    if (_discard) {
+      int n = std::min( _discard, size_t(_samp_avail) );
+
+      _buf_offset += n;
+      _samp_avail -= n;
+      _discard -= n;
+      continue;
+    }
+
+    if (!_changes.empty()) {
+      for (osmosdr_change_marks::changes_t::iterator it = _changes.begin();
+           it != _changes.end(); ++it)
+        add_item_tag( 0, nitems_written(0) + produced,
+                      pmt::pmt_string_to_symbol( it->first ),
+                      pmt::pmt_from_double( it->second ) );
+      _changes.clear();
+    }
+
+    unsigned short *buf = _buf[_buf_head] + _buf_offset;
+    int n, m;
+
+    if ( _ddc.enabled() ) {
+      /* decim device samples per output, the ddc keeps what is left over */
+      n = std::min( (noutput_items - produced) * int(_ddc.decim()), _samp_avail );
+      gr_complex *in = _ddc.input( n );
+
+      for (int i = 0; i < n; ++i)
+        in[i] = _lut[ *(buf + i) ];
+
+      m = _ddc.process( out, noutput_items - produced );
+    } else {
+      n = m = std::min( noutput_items - produced, _samp_avail );
+
+      for (int i = 0; i < n; ++i)
+        out[i] = _lut[ *(buf + i) ];
+    }
+
+    out += m;
+    _buf_offset += n;
+    _samp_avail -= n;
+    produced += m;
   }
 
-  return noutput_items;
+  return produced;
 }
 
 std::vector<std::string> rtl_source_c::get_devices()
@@ -414,13 +544,21 @@ osmosdr::meta_range_t rtl_source_c::get_sample_rates()
 //  range += osmosdr::range_t( 3000000 ); // may work
 //  range += osmosdr::range_t( 3200000 ); // max rate
 
-  return range;
+  return _ddc.output_rates( range );
+}
+
+double rtl_source_c::set_sample_rate( double rate )
+{
+  return _setters.call( "rate", boost::bind( &rtl_source_c::apply_sample_rate, this, rate ) );
 }
 
-double rtl_source_c::set_sample_rate(double rate)
+double rtl_source_c::apply_sample_rate( double rate )
 {
   if (_dev) {
-    rtlsdr_set_sample_rate( _dev, (uint32_t)rate );
+    rtlsdr_set_sample_rate( _dev, (uint32_t)_ddc.device_rate( rate ) );
+    _sample_rate = (double)rtlsdr_get_sample_rate( _dev );
+    _ddc.set_sample_rate( _sample_rate );
+    _marks.change( "rx_rate", get_sample_rate() );
   }
 
   return get_sample_rate();
@@ -428,13 +566,15 @@ double rtl_source_c::set_sample_rate(double rate)
 
 double rtl_source_c::get_sample_rate()
 {
-  if (_dev)
-    return (double)rtlsdr_get_sample_rate( _dev );
-
-  return 0;
+  return _ddc.output_rate( _sample_rate );
 }
 
 osmosdr::freq_range_t rtl_source_c::get_freq_range( size_t chan )
+{
+  return _ddc.output_freqs( _freq_range );
+}
+
+osmosdr::freq_range_t rtl_source_c::query_freq_range()
 {
   osmosdr::freq_range_t range;
 
@@ -468,34 +608,45 @@ osmosdr::freq_range_t rtl_source_c::get_freq_range( size_t chan )
 
 double rtl_source_c::set_center_freq( double freq, size_t chan )
 {
-  if (_dev)
-    rtlsdr_set_center_freq( _dev, (uint32_t)freq );
+  return _setters.call( "freq", boost::bind( &rtl_source_c::apply_center_freq, this, freq, chan ) );
+}
+
+double rtl_source_c::apply_center_freq( double freq, size_t chan )
+{
+  if (_dev) {
+    rtlsdr_set_center_freq( _dev, (uint32_t)_ddc.device_freq( freq ) );
+    _center_freq = (double)rtlsdr_get_center_freq( _dev );
+    _marks.change( "rx_freq", get_center_freq( chan ) );
+  }
 
   return get_center_freq( chan );
 }
 
 double rtl_source_c::get_center_freq( size_t chan )
 {
-  if (_dev)
-    return (double)rtlsdr_get_center_freq( _dev );
-
-  return 0;
+  return _ddc.output_freq( _center_freq );
 }
 
 double rtl_source_c::set_freq_corr( double ppm, size_t chan )
 {
-  if ( _dev )
+  return _setters.call( "corr", boost::bind( &rtl_source_c::apply_freq_corr, this, ppm, chan ) );
+}
+
+double rtl_source_c::apply_freq_corr( double ppm, size_t chan )
+{
+  if ( _dev ) {
     rtlsdr_set_freq_correction( _dev, (int)ppm );
+    _freq_corr = (double)rtlsdr_get_freq_correction( _dev );
+    _center_freq = (double)rtlsdr_get_center_freq( _dev );
+    _marks.change( "rx_freq", get_center_freq( chan ) );
+  }
 
   return get_freq_corr( chan );
 }
 
 double rtl_source_c::get_freq_corr( size_t chan )
 {
-  if ( _dev )
-    return (double)rtlsdr_get_freq_correction( _dev );
-
-  return 0;
+  return _freq_corr;
 }
 
 std::vector<std::string> rtl_source_c::get_gain_names( size_t chan )
@@ -514,6 +665,11 @@ std::vector<std::string> rtl_source_c::get_gain_names( size_t chan )
 }
 
 osmosdr::gain_range_t rtl_source_c::get_gain_range( size_t chan )
+{
+  return _gain_range;
+}
+
+osmosdr::gain_range_t rtl_source_c::query_gain_range()
 {
   osmosdr::gain_range_t range;
 
@@ -547,6 +703,11 @@ osmosdr::gain_range_t rtl_source_c::get_gain_range( const std::string & name, si
 }
 
 bool rtl_source_c::set_gain_mode( bool automatic, size_t chan )
+{
+  return _setters.call( "gain_mode", boost::bind( &rtl_source_c::apply_gain_mode, this, automatic, chan ) ) != 0;
+}
+
+double rtl_source_c::apply_gain_mode( bool automatic, size_t chan )
 {
   if (_dev) {
     if (!rtlsdr_set_tuner_gain_mode(_dev, int(!automatic))) {
@@ -566,10 +727,15 @@ bool rtl_source_c::get_gain_mode( size_t chan )
 
 double rtl_source_c::set_gain( double gain, size_t chan )
 {
-  osmosdr::gain_range_t rf_gains = rtl_source_c::get_gain_range( chan );
+  return _setters.call( "gain", boost::bind( &rtl_source_c::apply_gain, this, gain, chan ) );
+}
 
+double rtl_source_c::apply_gain( double gain, size_t chan )
+{
   if (_dev) {
-    rtlsdr_set_tuner_gain( _dev, int(rf_gains.clip(gain) * 10.0) );
+    rtlsdr_set_tuner_gain( _dev, int(_gain_range.clip(gain) * 10.0) );
+    _gain = ((double)rtlsdr_get_tuner_gain( _dev )) / 10.0;
+    _marks.change( "rx_gain", _gain );
   }
 
   return get_gain( chan );
@@ -586,10 +752,7 @@ double rtl_source_c::set_gain( double gain, const std::string & name, size_t cha
 
 double rtl_source_c::get_gain( size_t chan )
 {
-  if ( _dev )
-    return ((double)rtlsdr_get_tuner_gain( _dev )) / 10.0;
-
-  return 0;
+  return _gain;
 }
 
 double rtl_source_c::get_gain( const std::string & name, size_t chan )
@@ -601,7 +764,12 @@ double rtl_source_c::get_gain( const std::string & name, size_t chan )
   return get_gain( chan );
 }
 
-double rtl_source_c::set_if_gain(double gain, size_t chan)
+double rtl_source_c::set_if_gain( double gain, size_t chan )
+{
+  return _setters.call( "if_gain", boost::bind( &rtl_source_c::apply_if_gain, this, gain, chan ) );
+}
+
+double rtl_source_c::apply_if_gain( double gain, size_t chan )
 {
   if ( _dev ) {
     if ( rtlsdr_get_tuner_type(_dev) != RTLSDR_TUNER_E4000 ) {
@@ -684,3 +852,57 @@ std::string rtl_source_c::get_antenna( size_t chan )
 {
   return "RX";
 }
+
+bool rtl_source_c::fused_iq_balance()
+{
+  return true;
+}
+
+void rtl_source_c::set_iq_balance( const std::complex<double> &correction, size_t chan )
+{
+  _corr.set_iq_balance( correction );
+}
+
+std::complex<double> rtl_source_c::get_iq_balance( size_t chan )
+{
+  return _corr.iq_balance();
+}
+
+void rtl_source_c::set_dc_offset_mode( int mode, size_t chan )
+{
+  _corr.set_dc_offset_mode( mode );
+}
+
+void rtl_source_c::set_dc_offset( const std::complex<double> &offset, size_t chan )
+{
+  _corr.set_dc_offset( offset );
+}
+
+bool rtl_source_c::set_sweep( const std::vector< double > &freqs,
+                              double dwell, double settle,
+                              bool tag_hops, size_t chan )
+{
+  _tag_hops = tag_hops;
+
+  _sweep.start( freqs, size_t((settle + dwell) * _sample_rate), settle );
+
+  return true;
+}
+
+void rtl_source_c::sweep_tune( size_t index, double freq )
+{
+  set_center_freq( freq );
+
+  if (_tag_hops)
+    _marks.change( "sweep_hop", index );
+}
+
+osmosdr_future_t rtl_source_c::post_center_freq( double freq, size_t chan )
+{
+  return _setters.post( "freq", boost::bind( &rtl_source_c::apply_center_freq, this, freq, chan ) );
+}
+
+osmosdr_future_t rtl_source_c::post_gain( double gain, size_t chan )
+{
+  return _setters.post( "gain", boost::bind( &rtl_source_c::apply_gain, this, gain, chan ) );
+}
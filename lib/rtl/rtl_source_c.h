@@ -29,6 +29,12 @@
 #include <boost/thread/condition_variable.hpp>
 
 #include "osmosdr_src_iface.h"
+#include "osmosdr_setter_queue.h"
+#include "osmosdr_recorder.h"
+#include "osmosdr_change_marks.h"
+#include "osmosdr_sweep.h"
+#include "osmosdr_correction.h"
+#include "osmosdr_ddc.h"
 
 class rtl_source_c;
 typedef struct rtlsdr_dev rtlsdr_dev_t;
@@ -51,9 +57,12 @@ typedef boost::shared_ptr<rtl_source_c> rtl_source_c_sptr;
  *
  * To avoid accidental use of raw pointers, rtl_source_c's
  * constructor is private. make_rtl_source_c is the public
- * interface for creating new instances.
+ * interface for creating new instances. A device opened with
+ * rtl_source_c::open_device() is taken over, otherwise the arguments
+ * are used to open one.
  */
-rtl_source_c_sptr make_rtl_source_c (const std::string & args = "");
+rtl_source_c_sptr make_rtl_source_c (const std::string & args = "",
+                                     rtlsdr_dev_t *dev = NULL);
 
 /*!
  * \brief Provides a stream of complex samples.
@@ -68,12 +77,13 @@ private:
   // The friend declaration allows make_rtl_source_c to
   // access the private constructor.
 
-  friend rtl_source_c_sptr make_rtl_source_c (const std::string & args);
+  friend rtl_source_c_sptr make_rtl_source_c (const std::string & args,
+                                              rtlsdr_dev_t *dev);
 
   /*!
    * \brief Provides a stream of complex samples.
    */
-  rtl_source_c (const std::string & args);  	// private constructor
+  rtl_source_c (const std::string & args, rtlsdr_dev_t *dev);  	// private constructor
 
 public:
   ~rtl_source_c ();	// public destructor
@@ -84,6 +94,10 @@ public:
 
   static std::vector< std::string > get_devices();
 
+  /* the slow part of the construction, safe to run on several threads */
+  static rtlsdr_dev_t *open_device( const std::string &args );
+  static void close_device( rtlsdr_dev_t *dev );
+
   size_t get_num_channels( void );
 
   osmosdr::meta_range_t get_sample_rates( void );
@@ -112,13 +126,39 @@ public:
   std::string set_antenna( const std::string & antenna, size_t chan = 0 );
   std::string get_antenna( size_t chan = 0 );
 
+  bool set_sweep( const std::vector< double > &freqs,
+                  double dwell, double settle,
+                  bool tag_hops = true, size_t chan = 0 );
+
+  osmosdr_future_t post_center_freq( double freq, size_t chan = 0 );
+  osmosdr_future_t post_gain( double gain, size_t chan = 0 );
+
+  bool fused_iq_balance( void );
+  void set_iq_balance( const std::complex<double> &correction, size_t chan = 0 );
+  std::complex<double> get_iq_balance( size_t chan = 0 );
+
+  void set_dc_offset_mode( int mode, size_t chan = 0 );
+  void set_dc_offset( const std::complex<double> &offset, size_t chan = 0 );
+
 private:
+  double apply_sample_rate( double rate );
+  double apply_center_freq( double freq, size_t chan );
+  double apply_freq_corr( double ppm, size_t chan );
+  double apply_gain_mode( bool automatic, size_t chan );
+  double apply_gain( double gain, size_t chan );
+  double apply_if_gain( double gain, size_t chan );
+
+  osmosdr::freq_range_t query_freq_range();
+  osmosdr::gain_range_t query_gain_range();
+
   static void _rtlsdr_callback(unsigned char *buf, uint32_t len, void *ctx);
   void rtlsdr_callback(unsigned char *buf, uint32_t len);
   static void _rtlsdr_wait(rtl_source_c *obj);
   void rtlsdr_wait();
 
   std::vector<gr_complex> _lut;
+  osmosdr_correction _corr; /* baked into _lut by work() */
+  osmosdr_ddc _ddc;         /* between _lut and the output, if enabled */
 
   rtlsdr_dev_t *_dev;
   gruel::thread _thread;
@@ -138,6 +178,27 @@ private:
   bool _auto_gain;
   double _if_gain;
   unsigned int _skipped;
+
+  /* last applied settings and fixed capabilities, the getters answer from here */
+  double _sample_rate;
+  double _center_freq;
+  double _freq_corr;
+  double _gain;
+  osmosdr::freq_range_t _freq_range;
+  osmosdr::gain_range_t _gain_range;
+
+  osmosdr_recorder_sptr _recorder;
+
+  osmosdr_change_marks _marks;
+  osmosdr_change_marks::changes_t _changes; /* to be tagged after settling */
+  double _settle;                           /* seconds dropped after a change */
+  size_t _discard;                          /* samples left to drop */
+
+  osmosdr_setter_queue _setters; /* before _sweep, which tunes through it */
+
+  void sweep_tune( size_t index, double freq );
+  bool _tag_hops;
+  osmosdr_sweep _sweep;
 };
 
 #endif /* INCLUDED_RTLSDR_SOURCE_C_H */
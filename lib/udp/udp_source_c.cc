@@ -0,0 +1,656 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2013 Dimitri Stolnikov <horiz0n@gmx.net>
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * config.h is generated by configure.  It contains the results
+ * of probing for features, options etc.  It should be the first
+ * file included in your .cc file.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* for recvmmsg() */
+#endif
+
+#include "udp_source_c.h"
+#include <gr_io_signature.h>
+#include <gruel/pmt.h>
+
+#include <boost/assign.hpp>
+#include <boost/format.hpp>
+#include <boost/algorithm/string.hpp>
+
+#include <stdexcept>
+#include <iostream>
+#include <algorithm>
+#include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+
+#include <osmosdr_arg_helpers.h>
+
+using namespace boost::assign;
+
+#define HEADER_LEN  4 /* 32 bit sequence number in network byte order */
+
+#define PSIZE      65536 /* max datagram size accepted */
+#define BATCH      32    /* datagrams per recvmmsg() call */
+#define RESYNC_WINDOWS 4 /* sequence jumps beyond this many windows restart */
+#define WINDOW     16    /* reorder window in datagrams */
+#define FIFO_LEN   (1 << 20) /* samples */
+#define RCVBUF     (8 * 1024 * 1024)
+#define RCV_TIMEO  100000 /* us, also flushes the reorder window on idle */
+
+/*
+ * Create a new instance of udp_source_c and return
+ * a boost shared_ptr.  This is effectively the public constructor.
+ */
+udp_source_c_sptr
+make_udp_source_c (const std::string &args)
+{
+  return gnuradio::get_initial_sptr(new udp_source_c (args));
+}
+
+static const int MIN_IN = 0;	// mininum number of input streams
+static const int MAX_IN = 0;	// maximum number of input streams
+static const int MIN_OUT = 1;	// minimum number of output streams
+static const int MAX_OUT = 1;	// maximum number of output streams
+
+/*
+ * The private constructor
+ */
+udp_source_c::udp_source_c (const std::string &args)
+  : gr_sync_block ("udp_source_c",
+        gr_make_io_signature (MIN_IN, MAX_IN, sizeof (gr_complex)),
+        gr_make_io_signature (MIN_OUT, MAX_OUT, sizeof (gr_complex))),
+    _sock(-1),
+    _format(OSMOSDR_FORMAT_CS16),
+    _psize(PSIZE),
+    _freq(0),
+    _rate(0),
+    _running(true),
+    _batch(BATCH),
+    _have_seq(false),
+    _next_seq(0),
+    _pkt_samples(0),
+    _fifo_head(0),
+    _fifo_used(0),
+    _fifo_total_in(0),
+    _fifo_total_out(0),
+    _received(0),
+    _lost(0),
+    _reordered(0),
+    _late(0),
+    _overflows(0),
+    _resyncs(0)
+{
+  std::string host = "0.0.0.0";
+  std::string port = "1234";
+  unsigned int window = WINDOW;
+  int rcvbuf = RCVBUF;
+
+  dict_t dict = params_to_dict(args);
+
+  if (dict.count("udp")) {
+    std::vector< std::string > tokens;
+    boost::algorithm::split( tokens, dict["udp"], boost::is_any_of(":") );
+
+    if ( tokens.size() == 1 && tokens[0].length() ) { // port only
+      port = tokens[0];
+    } else if ( tokens.size() == 2 ) {
+      if ( tokens[0].length() )
+        host = tokens[0];
+      if ( tokens[1].length() )
+        port = tokens[1];
+    }
+  }
+
+  if (dict.count("format"))
+    _format = string_to_format( dict["format"] );
+
+  if (dict.count("freq"))
+    _freq = boost::lexical_cast< double >( dict["freq"] );
+
+  if (dict.count("rate"))
+    _rate = boost::lexical_cast< double >( dict["rate"] );
+
+  if (dict.count("psize"))
+    _psize = boost::lexical_cast< size_t >( dict["psize"] );
+
+  if (dict.count("window"))
+    window = boost::lexical_cast< unsigned int >( dict["window"] );
+
+  if (dict.count("batch"))
+    _batch = boost::lexical_cast< unsigned int >( dict["batch"] );
+
+  if (dict.count("rcvbuf"))
+    rcvbuf = boost::lexical_cast< int >( dict["rcvbuf"] );
+
+  if (_freq < 0)
+    throw std::runtime_error("Parameter 'freq' may not be negative.");
+
+  if (0 == _rate)
+    throw std::runtime_error("Parameter 'rate' is missing in arguments.");
+
+  if (_psize <= HEADER_LEN)
+    _psize = PSIZE;
+
+  if (0 == window)
+    window = WINDOW;
+
+  if (0 == _batch)
+    _batch = BATCH;
+
+  struct addrinfo hints, *res = NULL;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_DGRAM;
+  hints.ai_protocol = IPPROTO_UDP;
+  hints.ai_flags = AI_PASSIVE;
+
+  int ret = getaddrinfo( host.c_str(), port.c_str(), &hints, &res );
+  if ( ret != 0 )
+    throw std::runtime_error( "Failed to resolve '" + host + ":" + port +
+                              "': " + gai_strerror(ret) );
+
+  _sock = socket( res->ai_family, res->ai_socktype, res->ai_protocol );
+  if ( _sock < 0 ) {
+    freeaddrinfo(res);
+    throw std::runtime_error("Failed to create UDP socket.");
+  }
+
+  int reuse = 1;
+  setsockopt( _sock, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse) );
+
+  /* a large socket buffer absorbs scheduling hiccups of the receive thread */
+  if ( setsockopt( _sock, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf) ) < 0 )
+    std::cerr << "Failed to set UDP receive buffer size." << std::endl;
+
+  struct timeval tv;
+  tv.tv_sec = 0;
+  tv.tv_usec = RCV_TIMEO;
+  setsockopt( _sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv) );
+
+  ret = bind( _sock, res->ai_addr, res->ai_addrlen );
+  freeaddrinfo(res);
+
+  if ( ret < 0 ) {
+    close( _sock );
+    _sock = -1;
+    throw std::runtime_error( "Failed to bind UDP socket to " +
+                              host + ":" + port + "." );
+  }
+
+  std::cerr << "Receiving " << format_to_string(_format) << " samples on "
+            << host << ":" << port << " (UDP)" << std::endl;
+
+  _batch_buf.resize( _batch * _psize );
+
+  _window.resize( window );
+  for (unsigned int i = 0; i < window; i++) {
+    _window[i].len = 0;
+    _window[i].valid = false;
+  }
+
+  _fifo.resize( FIFO_LEN );
+
+  _thread = gruel::thread(_udp_wait, this);
+}
+
+/*
+ * Our virtual destructor.
+ */
+udp_source_c::~udp_source_c ()
+{
+  _running = false;
+  _thread.join();
+
+  if ( _sock >= 0 ) {
+    close( _sock );
+    _sock = -1;
+  }
+
+  if ( _received ) {
+    std::cerr << "UDP source: " << _received << " datagrams received, "
+              << _lost << " lost, " << _reordered << " reordered, "
+              << _late << " late, " << _overflows << " overflows, "
+              << _resyncs << " resyncs."
+              << std::endl;
+  }
+}
+
+void udp_source_c::_udp_wait(udp_source_c *obj)
+{
+  obj->udp_wait();
+}
+
+void udp_source_c::udp_wait()
+{
+  std::vector< struct mmsghdr > msgs( _batch );
+  std::vector< struct iovec > iovs( _batch );
+
+  for (unsigned int i = 0; i < _batch; i++) {
+    iovs[i].iov_base = &_batch_buf[i * _psize];
+    iovs[i].iov_len = _psize;
+  }
+
+  while ( _running ) {
+    for (unsigned int i = 0; i < _batch; i++) {
+      memset( &msgs[i].msg_hdr, 0, sizeof(msgs[i].msg_hdr) );
+      msgs[i].msg_hdr.msg_iov = &iovs[i];
+      msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    /* block for the first datagram only, then take whatever is queued */
+    int count = recvmmsg( _sock, &msgs[0], _batch, MSG_WAITFORONE, NULL );
+
+    if ( count < 0 ) {
+      if ( errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR ) {
+        /* idle: don't keep samples behind a hole forever */
+        release_window( true );
+        _fifo_cond.notify_one();
+        continue;
+      }
+
+      perror("recvmmsg");
+      break;
+    }
+
+    for (int i = 0; i < count; i++) {
+      if ( msgs[i].msg_hdr.msg_flags & MSG_TRUNC ) {
+        std::cerr << "T" << std::flush; /* datagram larger than psize */
+        continue;
+      }
+
+      handle_packet( &_batch_buf[i * _psize], msgs[i].msg_len );
+    }
+
+    _fifo_cond.notify_one();
+  }
+
+  {
+    boost::mutex::scoped_lock lock( _fifo_mutex );
+    _running = false;
+  }
+
+  _fifo_cond.notify_one();
+}
+
+void udp_source_c::handle_packet( const unsigned char *pkt, size_t len )
+{
+  if ( len < HEADER_LEN )
+    return;
+
+  uint32_t seq;
+  memcpy( &seq, pkt, sizeof(seq) );
+  seq = ntohl( seq );
+
+  const unsigned char *payload = pkt + HEADER_LEN;
+  size_t payload_len = len - HEADER_LEN;
+  size_t nsamples = payload_len / format_sample_size( _format );
+
+  _received++;
+
+  if ( ! _have_seq ) {
+    _have_seq = true;
+    _next_seq = seq;
+  }
+
+  /* signed distance handles wrapping of the sequence counter */
+  int32_t delta = int32_t(seq - _next_seq);
+  int32_t bound = int32_t(RESYNC_WINDOWS * _window.size());
+
+  if ( delta <= -bound || delta >= bound ) {
+    /* the sender restarted or we lost track, start over at this datagram */
+    resync();
+    _next_seq = seq;
+    delta = 0;
+  }
+
+  if ( delta < 0 ) { /* duplicate or we already gave up waiting for it */
+    _late++;
+    return;
+  }
+
+  /* too far ahead to fit the window: give up on the oldest missing ones */
+  while ( delta >= int32_t(_window.size()) ) {
+    slot_t &slot = _window[ _next_seq % _window.size() ];
+
+    if ( slot.valid ) {
+      push_samples( &slot.data[0], slot.len / format_sample_size( _format ) );
+      slot.valid = false;
+    } else {
+      push_gap( 1 );
+    }
+
+    _next_seq++;
+    release_window( false );
+
+    delta = int32_t(seq - _next_seq);
+  }
+
+  if ( 0 == delta ) { /* in order, the common case: no extra copy */
+    _pkt_samples = nsamples;
+    push_samples( payload, nsamples );
+    _next_seq++;
+    release_window( false );
+    return;
+  }
+
+  slot_t &slot = _window[ seq % _window.size() ];
+
+  if ( slot.valid ) { /* duplicate */
+    _late++;
+    return;
+  }
+
+  slot.data.assign( payload, payload + payload_len );
+  slot.len = payload_len;
+  slot.valid = true;
+
+  _reordered++;
+}
+
+void udp_source_c::resync()
+{
+  /* hand out what arrived in order, the missing ones are not coming anymore */
+  for (size_t i = 0; i < _window.size(); i++) {
+    slot_t &slot = _window[ _next_seq % _window.size() ];
+
+    if ( slot.valid ) {
+      push_samples( &slot.data[0], slot.len / format_sample_size( _format ) );
+      slot.valid = false;
+    }
+
+    _next_seq++;
+  }
+
+  _resyncs++;
+
+  /* how much was lost is unknown, mark the discontinuity with a count of 0 */
+  boost::mutex::scoped_lock lock( _fifo_mutex );
+  add_drop( 0 );
+}
+
+void udp_source_c::add_drop( uint64_t nsamples )
+{
+  uint64_t pos = _fifo_total_in;
+
+  /* merge drops at the same position or right behind a gap into a single tag */
+  if ( ! _drops.empty() &&
+       _drops.back().first <= pos &&
+       _drops.back().first + _drops.back().second >= pos )
+    _drops.back().second += nsamples;
+  else
+    _drops.push_back( std::make_pair( pos, nsamples ) );
+}
+
+void udp_source_c::release_window( bool flush )
+{
+  size_t pending = 0;
+
+  for (size_t i = 0; i < _window.size(); i++)
+    if ( _window[i].valid )
+      pending++;
+
+  while ( pending ) {
+    slot_t &slot = _window[ _next_seq % _window.size() ];
+
+    if ( slot.valid ) {
+      push_samples( &slot.data[0], slot.len / format_sample_size( _format ) );
+      slot.valid = false;
+      pending--;
+    } else if ( flush ) {
+      push_gap( 1 );
+    } else {
+      break;
+    }
+
+    _next_seq++;
+  }
+}
+
+void udp_source_c::push_samples( const unsigned char *payload, size_t nsamples )
+{
+  size_t tail;
+
+  {
+    boost::mutex::scoped_lock lock( _fifo_mutex );
+
+    if ( nsamples > _fifo.size() - _fifo_used ) {
+      std::cerr << "O" << std::flush;
+      _overflows++;
+      add_drop( nsamples ); /* tagged on the next sample that makes it */
+      return;
+    }
+
+    tail = (_fifo_head + _fifo_used) % _fifo.size();
+  }
+
+  /* the consumer never touches the free part of the fifo, so we may
+   * convert into it without holding the lock */
+  size_t first = std::min( nsamples, _fifo.size() - tail );
+  size_t sample_size = format_sample_size( _format );
+
+  convert_to_cf32( _format, payload, &_fifo[tail], first );
+  if ( nsamples > first )
+    convert_to_cf32( _format, payload + first * sample_size,
+                     &_fifo[0], nsamples - first );
+
+  {
+    boost::mutex::scoped_lock lock( _fifo_mutex );
+
+    _fifo_used += nsamples;
+    _fifo_total_in += nsamples;
+  }
+}
+
+void udp_source_c::push_gap( uint32_t packets )
+{
+  size_t nsamples = packets * _pkt_samples;
+
+  _lost += packets;
+
+  if ( 0 == nsamples )
+    return;
+
+  boost::mutex::scoped_lock lock( _fifo_mutex );
+
+  size_t room = _fifo.size() - _fifo_used;
+
+  if ( nsamples > room ) {
+    std::cerr << "O" << std::flush;
+    _overflows++;
+    add_drop( nsamples );
+    return;
+  }
+
+  size_t tail = (_fifo_head + _fifo_used) % _fifo.size();
+  size_t first = std::min( nsamples, _fifo.size() - tail );
+
+  std::fill( _fifo.begin() + tail, _fifo.begin() + tail + first, gr_complex(0) );
+  std::fill( _fifo.begin(), _fifo.begin() + (nsamples - first), gr_complex(0) );
+
+  add_drop( nsamples );
+
+  _fifo_used += nsamples;
+  _fifo_total_in += nsamples;
+}
+
+int udp_source_c::work( int noutput_items,
+                        gr_vector_const_void_star &input_items,
+                        gr_vector_void_star &output_items )
+{
+  gr_complex *out = (gr_complex *)output_items[0];
+
+  boost::mutex::scoped_lock lock( _fifo_mutex );
+
+  while ( _fifo_used == 0 && _running )
+    _fifo_cond.wait( lock );
+
+  if ( _fifo_used == 0 && ! _running )
+    return WORK_DONE;
+
+  size_t count = std::min( size_t(noutput_items), _fifo_used );
+  size_t first = std::min( count, _fifo.size() - _fifo_head );
+
+  memcpy( out, &_fifo[_fifo_head], first * sizeof(gr_complex) );
+  if ( count > first )
+    memcpy( out + first, &_fifo[0], (count - first) * sizeof(gr_complex) );
+
+  while ( ! _drops.empty() && _drops.front().first < _fifo_total_out + count ) {
+    uint64_t pos = std::max( _drops.front().first, _fifo_total_out );
+
+    add_item_tag( 0, nitems_written(0) + (pos - _fifo_total_out),
+                  pmt::pmt_string_to_symbol("rx_drop"),
+                  pmt::pmt_from_uint64( _drops.front().second ),
+                  pmt::pmt_string_to_symbol( name() ) );
+
+    _drops.pop_front();
+  }
+
+  _fifo_head = (_fifo_head + count) % _fifo.size();
+  _fifo_used -= count;
+  _fifo_total_out += count;
+
+  return count;
+}
+
+std::vector<std::string> udp_source_c::get_devices()
+{
+  std::vector<std::string> devices;
+
+  std::string args = "udp=0.0.0.0:1234,format=cs16,rate=1e6,freq=100e6";
+  args += ",label='UDP IQ Stream'";
+  devices.push_back( args );
+
+  return devices;
+}
+
+size_t udp_source_c::get_num_channels( void )
+{
+  return 1;
+}
+
+osmosdr::meta_range_t udp_source_c::get_sample_rates( void )
+{
+  osmosdr::meta_range_t range;
+
+  range += osmosdr::range_t( get_sample_rate() );
+
+  return range;
+}
+
+double udp_source_c::set_sample_rate( double rate )
+{
+  return get_sample_rate();
+}
+
+double udp_source_c::get_sample_rate( void )
+{
+  return _rate;
+}
+
+osmosdr::freq_range_t udp_source_c::get_freq_range( size_t chan )
+{
+  return osmosdr::freq_range_t(_freq, _freq);
+}
+
+double udp_source_c::set_center_freq( double freq, size_t chan )
+{
+  return get_center_freq(chan);
+}
+
+double udp_source_c::get_center_freq( size_t chan )
+{
+  return _freq;
+}
+
+double udp_source_c::set_freq_corr( double ppm, size_t chan )
+{
+  return get_freq_corr( chan );
+}
+
+double udp_source_c::get_freq_corr( size_t chan )
+{
+  return 0;
+}
+
+std::vector<std::string> udp_source_c::get_gain_names( size_t chan )
+{
+  return std::vector< std::string >();
+}
+
+osmosdr::gain_range_t udp_source_c::get_gain_range( size_t chan )
+{
+  return osmosdr::gain_range_t();
+}
+
+osmosdr::gain_range_t udp_source_c::get_gain_range( const std::string & name, size_t chan )
+{
+  return get_gain_range( chan );
+}
+
+double udp_source_c::set_gain( double gain, size_t chan )
+{
+  return get_gain(chan);
+}
+
+double udp_source_c::set_gain( double gain, const std::string & name, size_t chan )
+{
+  return set_gain(gain, chan);
+}
+
+double udp_source_c::get_gain( size_t chan )
+{
+  return 0;
+}
+
+double udp_source_c::get_gain( const std::string & name, size_t chan )
+{
+  return get_gain(chan);
+}
+
+std::vector< std::string > udp_source_c::get_antennas( size_t chan )
+{
+  std::vector< std::string > antennas;
+
+  antennas += get_antenna(chan);
+
+  return antennas;
+}
+
+std::string udp_source_c::set_antenna( const std::string & antenna, size_t chan )
+{
+  return get_antenna(chan);
+}
+
+std::string udp_source_c::get_antenna( size_t chan )
+{
+  return "RX";
+}
@@ -0,0 +1,149 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2013 Dimitri Stolnikov <horiz0n@gmx.net>
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef INCLUDED_UDP_SOURCE_C_H
+#define INCLUDED_UDP_SOURCE_C_H
+
+#include <gr_sync_block.h>
+
+#include <gruel/thread.h>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+#include <deque>
+
+#include "osmosdr_src_iface.h"
+#include "osmosdr_convert.h"
+
+class udp_source_c;
+
+typedef boost::shared_ptr<udp_source_c> udp_source_c_sptr;
+
+udp_source_c_sptr make_udp_source_c (const std::string & args = "");
+
+/*!
+ * \brief Receives sequence numbered IQ datagrams from the network.
+ * \ingroup block
+ *
+ * Every datagram starts with a 32 bit sequence number in network byte order
+ * followed by the interleaved IQ payload in the configured sample format.
+ * Datagrams are received in batches, reordered within a small window, and
+ * lost datagrams are replaced with zeros. An "rx_drop" stream tag carrying
+ * the number of inserted zero samples is attached to the first of them.
+ * Samples dropped because the fifo was full are tagged the same way, on the
+ * first sample after them. When the sequence counter jumps by more than a
+ * few windows (the sender restarted) the window is flushed and the stream
+ * resyncs on the new counter, with an rx_drop tag of 0 marking the jump.
+ */
+class udp_source_c :
+    public gr_sync_block,
+    public osmosdr_src_iface
+{
+private:
+  friend udp_source_c_sptr make_udp_source_c (const std::string & args);
+
+  udp_source_c (const std::string & args);
+
+public:
+  ~udp_source_c ();
+
+  int work( int noutput_items,
+            gr_vector_const_void_star &input_items,
+            gr_vector_void_star &output_items );
+
+  static std::vector< std::string > get_devices();
+
+  size_t get_num_channels( void );
+
+  osmosdr::meta_range_t get_sample_rates( void );
+  double set_sample_rate( double rate );
+  double get_sample_rate( void );
+
+  osmosdr::freq_range_t get_freq_range( size_t chan = 0 );
+  double set_center_freq( double freq, size_t chan = 0 );
+  double get_center_freq( size_t chan = 0 );
+  double set_freq_corr( double ppm, size_t chan = 0 );
+  double get_freq_corr( size_t chan = 0 );
+
+  std::vector<std::string> get_gain_names( size_t chan = 0 );
+  osmosdr::gain_range_t get_gain_range( size_t chan = 0 );
+  osmosdr::gain_range_t get_gain_range( const std::string & name, size_t chan = 0 );
+  double set_gain( double gain, size_t chan = 0 );
+  double set_gain( double gain, const std::string & name, size_t chan = 0 );
+  double get_gain( size_t chan = 0 );
+  double get_gain( const std::string & name, size_t chan = 0 );
+
+  std::vector< std::string > get_antennas( size_t chan = 0 );
+  std::string set_antenna( const std::string & antenna, size_t chan = 0 );
+  std::string get_antenna( size_t chan = 0 );
+
+private:
+  struct slot_t {
+    std::vector< unsigned char > data;
+    size_t len;
+    bool valid;
+  };
+
+  static void _udp_wait(udp_source_c *obj);
+  void udp_wait();
+
+  void handle_packet( const unsigned char *pkt, size_t len );
+  void release_window( bool flush );
+  void push_samples( const unsigned char *payload, size_t nsamples );
+  void push_gap( uint32_t packets );
+  void resync();
+  void add_drop( uint64_t nsamples ); /* with _fifo_mutex held */
+
+  int _sock;
+  osmosdr_format_t _format;
+  size_t _psize;
+  double _freq, _rate;
+
+  gruel::thread _thread;
+  bool _running;
+
+  /* receive side, only touched by the receive thread */
+  unsigned int _batch;
+  std::vector< unsigned char > _batch_buf;
+  std::vector< slot_t > _window;
+  bool _have_seq;
+  uint32_t _next_seq;
+  size_t _pkt_samples;
+
+  /* sample fifo shared between receive thread and work() */
+  std::vector< gr_complex > _fifo;
+  size_t _fifo_head;
+  size_t _fifo_used;
+  uint64_t _fifo_total_in;  /* samples ever written into the fifo */
+  uint64_t _fifo_total_out; /* samples ever read from the fifo */
+  std::deque< std::pair< uint64_t, uint64_t > > _drops; /* (fifo pos, count) */
+  boost::mutex _fifo_mutex;
+  boost::condition_variable _fifo_cond;
+  std::vector< gr_complex > _conv;
+
+  /* statistics */
+  uint64_t _received;
+  uint64_t _lost;
+  uint64_t _reordered;
+  uint64_t _late;
+  uint64_t _overflows;
+  uint64_t _resyncs;
+};
+
+#endif /* INCLUDED_UDP_SOURCE_C_H */
@@ -24,6 +24,8 @@
 
 //#include <uhd/property_tree.hpp>
 
+#include <osmosdr/osmosdr_source_c.h>
+
 #include "osmosdr_arg_helpers.h"
 
 #include "uhd_source_c.h"
@@ -262,3 +264,21 @@ std::string uhd_source_c::get_antenna( size_t chan )
 {
   return _src->get_antenna(chan);
 }
+
+void uhd_source_c::set_dc_offset_mode( int mode, size_t chan )
+{
+  /* the FPGA of the usrp does the estimation and correction itself */
+  if ( osmosdr_source_c::DCOffsetOff == mode ) {
+    _src->set_auto_dc_offset(false, chan);
+    _src->set_dc_offset(std::complex<double>(0.0, 0.0), chan);
+  } else if ( osmosdr_source_c::DCOffsetManual == mode ) {
+    _src->set_auto_dc_offset(false, chan);
+  } else if ( osmosdr_source_c::DCOffsetAutomatic == mode ) {
+    _src->set_auto_dc_offset(true, chan);
+  }
+}
+
+void uhd_source_c::set_dc_offset( const std::complex<double> &offset, size_t chan )
+{
+  _src->set_dc_offset(offset, chan);
+}
@@ -31,6 +31,10 @@
 %template(range_vector_t) std::vector<osmosdr::range_t>; //define before range
 %include <osmosdr/osmosdr_ranges.h>
 
+// futures are of no use without the C++ API, python calls the blocking setters
+%ignore osmosdr_source_c::post_center_freq;
+%ignore osmosdr_source_c::post_gain;
+
 GR_SWIG_BLOCK_MAGIC(osmosdr,source_c);
 %include "osmosdr/osmosdr_source_c.h"
 